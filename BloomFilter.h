@@ -0,0 +1,84 @@
+#ifndef P3_BLOOMFILTER_H
+#define P3_BLOOMFILTER_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Blocked Bloom filter over precomputed hash values: all NUM_PROBES bits of a key fall in one
+// 512-bit block, so a query touches a single cache line. Bits cannot be cleared, so callers
+// rebuild it when enough removed keys have gone stale.
+class BlockedBloomFilter {
+private:
+    static constexpr size_t NUM_PROBES = 6;
+    static constexpr size_t WORDS_PER_BLOCK = 8;
+    static constexpr size_t BITS_PER_BLOCK = WORDS_PER_BLOCK * 64;
+
+    struct alignas(64) Block {
+        uint64_t words[WORDS_PER_BLOCK];
+    };
+
+    std::unique_ptr<Block[]> blocks;
+    size_t num_blocks = 0;
+    size_t bits_per_key;
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t block_index(uint64_t mixed) const {
+        return static_cast<size_t>(((mixed >> 32) * num_blocks) >> 32);
+    }
+
+public:
+    explicit BlockedBloomFilter(size_t expected_keys, size_t bits_per_key = 10) : bits_per_key(bits_per_key) {
+        reset(expected_keys);
+    }
+
+    void reset(size_t expected_keys) {
+        size_t new_blocks = (expected_keys * bits_per_key + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK;
+        if (new_blocks == 0) new_blocks = 1;
+        if (new_blocks != num_blocks) {
+            blocks.reset(new Block[new_blocks]);
+            num_blocks = new_blocks;
+        }
+        memset(blocks.get(), 0, num_blocks * sizeof(Block));
+    }
+
+    void add(size_t hash) {
+        uint64_t mixed = mix(hash);
+        Block& block = blocks[block_index(mixed)];
+        uint64_t bits = mixed * 0x9e3779b97f4a7c15ULL;
+        for (size_t i = 0; i < NUM_PROBES; i++) {
+            size_t bit = bits >> 55;
+            block.words[bit / 64] |= 1ULL << (bit % 64);
+            bits <<= 9;
+        }
+    }
+
+    size_t memory_bytes() const {
+        return num_blocks * sizeof(Block);
+    }
+
+    bool may_contain(size_t hash) const {
+        uint64_t mixed = mix(hash);
+        const Block& block = blocks[block_index(mixed)];
+        uint64_t bits = mixed * 0x9e3779b97f4a7c15ULL;
+        for (size_t i = 0; i < NUM_PROBES; i++) {
+            size_t bit = bits >> 55;
+            if (!(block.words[bit / 64] & (1ULL << (bit % 64))))
+                return false;
+            bits <<= 9;
+        }
+        return true;
+    }
+};
+
+#endif //P3_BLOOMFILTER_H
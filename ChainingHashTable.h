@@ -4,16 +4,27 @@
 
 #include <iostream>
 #include <list>
+#include <map>
+#include <memory>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <functional>
 #include "hash_functions.h"
 #include "HashTable.h"
+#include "memory_policy.h"
 #include "OpenAddrHashTable.h"
+#include "FrozenHashTable.h"
 
+// Buckets start as lists and switch to an ordered tree once they hold more than
+// TREEIFY_THRESHOLD entries (as in Java's HashMap), so K must also provide operator<.
 template<typename K, typename V>
 class ChainingHashTable : protected HashTable<K, V>{
 private:
+    static constexpr size_t TREEIFY_THRESHOLD = 8;
+    static constexpr size_t UNTREEIFY_THRESHOLD = 6;
+
     struct Entry {
         K key;
         V value;
@@ -21,107 +32,312 @@ private:
 
     };
 
-    std::list<Entry>* table;
+    struct Bucket {
+        std::list<Entry> chain;
+        std::unique_ptr<std::map<K, V>> tree;
+
+        size_t length() const {
+            return tree ? tree->size() : chain.size();
+        }
+    };
+
+    Bucket* table;
     size_t capacity;
+    FastMod mod_capacity;
     size_t min_capacity;
     size_t size;
     std::function<size_t(const K&, size_t)> hasher;
+    MemoryPolicy memory_policy;
 
-    void rehash_up() override {
-        size_t new_capacity = next_prime(capacity * 2);
-        std::list<Entry>* new_table = new std::list<Entry>[new_capacity];
+    // optional batch form of hasher used by insert_many/get_many, e.g. hash_many for DJB2Hash
+    std::function<void(std::span<const K>, std::span<size_t>)> batch_hasher;
+    static constexpr size_t BATCH = 32;
+
+    // keyed hashing: when set, `hasher` forwards to it with the table's current seed
+    std::function<size_t(const K&, size_t, const HashSeed&)> seeded_hasher;
+    HashSeed seed;
+    ReseedTrigger reseed_trigger;
+    size_t reseed_count = 0;
+
+    static void treeify(Bucket& bucket) {
+        bucket.tree = std::make_unique<std::map<K, V>>();
+        for (Entry& e : bucket.chain)
+            bucket.tree->emplace(std::move(e.key), std::move(e.value));
+        bucket.chain.clear();
+    }
+
+    static void untreeify(Bucket& bucket) {
+        for (auto& [key, value] : *bucket.tree)
+            bucket.chain.push_back({key, std::move(value)});
+        bucket.tree.reset();
+    }
+
+    // appends a key known to be absent from the bucket
+    static void append(Bucket& bucket, const K& key, const V& value) {
+        if (bucket.tree) {
+            bucket.tree->emplace(key, value);
+            return;
+        }
+        bucket.chain.push_back({key, value});
+        if (bucket.chain.size() > TREEIFY_THRESHOLD)
+            treeify(bucket);
+    }
+
+    void rehash(size_t new_capacity) {
+        Bucket* new_table = allocate_slots<Bucket>(new_capacity, memory_policy);
+        FastMod new_mod(new_capacity);
 
         for (size_t i = 0; i < capacity; i++) {
-            for (const Entry& e : table[i]) {
-                size_t index = hasher(e.key, capacity) % new_capacity;
-                new_table[index].push_back(e);
+            for (const Entry& e : table[i].chain)
+                append(new_table[new_mod(hasher(e.key, new_capacity))], e.key, e.value);
+            if (table[i].tree) {
+                for (const auto& [key, value] : *table[i].tree)
+                    append(new_table[new_mod(hasher(key, new_capacity))], key, value);
             }
         }
-        delete[] table;
+        release_slots(table, capacity, memory_policy);
         table = new_table;
         capacity = new_capacity;
+        mod_capacity = new_mod;
+    }
+
+    static V* find(Bucket& bucket, const K& key) {
+        if (bucket.tree) {
+            auto it = bucket.tree->find(key);
+            return it == bucket.tree->end() ? nullptr : &it->second;
+        }
+        for (Entry& e : bucket.chain) {
+            if (e.key == key)
+                return &e.value;
+        }
+        return nullptr;
+    }
+
+    void rehash_up() override {
+        rehash(next_table_prime(capacity * 2));
     }
 
     void rehash_down() override {
         if (capacity <= min_capacity) return;
 
-        size_t new_capacity = previous_prime(capacity / 2);
+        size_t new_capacity = previous_table_prime(capacity / 2);
         if (new_capacity < min_capacity) {
             new_capacity = min_capacity;
         }
-
-        std::list<Entry>* new_table = new std::list<Entry>[new_capacity];
-
-        for (size_t i = 0; i < capacity; i++) {
-            for (const Entry& e : table[i]) {
-                size_t index = hasher(e.key, capacity) % new_capacity;
-                new_table[index].push_back(e);
-            }
-        }
-        delete[] table;
-        table = new_table;
-        capacity = new_capacity;
+        rehash(new_capacity);
     }
 
 public:
-    explicit ChainingHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc)
+    explicit ChainingHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc,
+                               MemoryPolicy policy = {})
             : capacity(next_prime(initial_capacity)),
               size(0), min_capacity(next_prime(initial_capacity)),
-              hasher(hashFunc){
-        table = new std::list<Entry>[capacity];
+              hasher(hashFunc), memory_policy(policy) {
+        mod_capacity = FastMod(capacity);
+        table = allocate_slots<Bucket>(capacity, memory_policy);
+    }
+
+    // keyed hashing for untrusted keys: the table draws a random seed and, if reseed_after is
+    // non-zero, draws a new one and rehashes when an insert makes a chain longer than that plus
+    // log2 of the size, at most once per `size` inserts (see ReseedTrigger)
+    explicit ChainingHashTable(size_t initial_capacity,
+                               std::function<size_t(const K&, size_t, const HashSeed&)> seededHashFunc,
+                               size_t reseed_after = 0, MemoryPolicy policy = {})
+            : capacity(next_prime(initial_capacity)),
+              size(0), min_capacity(next_prime(initial_capacity)),
+              memory_policy(policy), seeded_hasher(std::move(seededHashFunc)),
+              seed(HashSeed::random()), reseed_trigger{ reseed_after } {
+        hasher = [this](const K& key, size_t cap) { return seeded_hasher(key, cap, seed); };
+        mod_capacity = FastMod(capacity);
+        table = allocate_slots<Bucket>(capacity, memory_policy);
     }
 
     ~ChainingHashTable() {
-        delete[] table;
+        release_slots(table, capacity, memory_policy);
     }
 
     void insert(const K& key, const V& value) override {
         if ((size + 1) * 2 > capacity)
             rehash_up();
+        insert_hashed(key, hasher(key, capacity), value);
+    }
+
+    // inserts keys[i] -> values[i] for every i; room for all of them is made up front and the
+    // keys are hashed a batch at a time by the batch hasher when one is set
+    void insert_many(std::span<const K> keys, std::span<const V> values) {
+        if (keys.size() != values.size())
+            throw std::invalid_argument("insert_many: keys and values differ in length");
+        if ((size + keys.size()) * 2 > capacity)
+            rehash(next_prime((size + keys.size()) * 2));
+        if (!batch_hasher || seeded_hasher) {
+            for (size_t i = 0; i < keys.size(); i++)
+                insert(keys[i], values[i]);
+            return;
+        }
+        size_t hashes[BATCH];
+        for (size_t start = 0; start < keys.size(); start += BATCH) {
+            size_t n = std::min(BATCH, keys.size() - start);
+            batch_hasher(keys.subspan(start, n), std::span<size_t>(hashes, n));
+            for (size_t i = 0; i < n; i++)
+                insert_hashed(keys[start + i], hashes[i], values[start + i]);
+        }
+    }
 
-        size_t index = hasher(key, capacity) % capacity;
+    // `batch` must compute exactly what the table's hasher does, for any capacity; it is not
+    // used by tables with keyed hashing
+    void set_batch_hasher(std::function<void(std::span<const K>, std::span<size_t>)> batch) {
+        batch_hasher = std::move(batch);
+    }
 
-        for (Entry& e : table[index]) {
-            if (e.key == key) {
-                e.value = value;
-                return;
-            }
+private:
+    void insert_hashed(const K& key, size_t hash, const V& value) {
+        Bucket& bucket = table[mod_capacity(hash)];
+
+        if (V* existing = find(bucket, key)) {
+            *existing = value;
+            return;
         }
 
-        table[index].push_back({key, value});
+        append(bucket, key, value);
         size++;
+
+        if (reseed_trigger.due(bucket.length(), size))
+            reseed();
+    }
+
+public:
+    void reseed() {
+        if (!seeded_hasher) return;
+        seed = HashSeed::random();
+        rehash(capacity);
+        reseed_trigger.reset();
+        reseed_count++;
+    }
+
+    // seeds drawn since construction, by reseed() calls and automatic reseeds alike
+    size_t reseeds() const {
+        return reseed_count;
     }
 
     bool remove(const K& key) override {
-        size_t index = hasher(key, capacity) % capacity;
-        for (auto it = table[index].begin(); it != table[index].end(); it++) {
-            if (it->key == key) {
-                table[index].erase(it);
-                size--;
-                if (size < capacity / 4) {
-                    rehash_down();
+        Bucket& bucket = table[mod_capacity(hasher(key, capacity))];
+        bool removed = false;
+        if (bucket.tree) {
+            removed = bucket.tree->erase(key) > 0;
+            if (removed && bucket.tree->size() < UNTREEIFY_THRESHOLD)
+                untreeify(bucket);
+        } else {
+            for (auto it = bucket.chain.begin(); it != bucket.chain.end(); it++) {
+                if (it->key == key) {
+                    bucket.chain.erase(it);
+                    removed = true;
+                    break;
                 }
-                return true;
             }
         }
-        return false;
+        if (!removed) return false;
+
+        size--;
+        if (size < capacity / 4) {
+            rehash_down();
+        }
+        return true;
+    }
+
+    // empties every bucket but keeps the bucket array, so only the entries' nodes are freed
+    void clear() {
+        for (size_t i = 0; i < capacity; i++) {
+            table[i].chain.clear();
+            table[i].tree.reset();
+        }
+        size = 0;
+    }
+
+    // rehashes into the smallest capacity that holds the current entries, but not below the
+    // initial one
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_prime(size * 2));
+        if (fitted < capacity) rehash(fitted);
     }
 
 
     V* getValue(const K& key) const override {
-        size_t index = hasher(key, capacity) % capacity;
-        for (Entry& e : table[index]) {
-            if (e.key == key)
-                return &e.value;
+        return find(table[mod_capacity(hasher(key, capacity))], key);
+    }
+
+    // looks up keys[i] into values[i] for every i, with the keys hashed a batch at a time by the
+    // batch hasher and every bucket of a batch prefetched before the first one is searched
+    void get_many(std::span<const K> keys, std::span<V*> values) const {
+        if (keys.size() != values.size())
+            throw std::invalid_argument("get_many: keys and values differ in length");
+        if (!batch_hasher || seeded_hasher) {
+            for (size_t i = 0; i < keys.size(); i++)
+                values[i] = getValue(keys[i]);
+            return;
+        }
+        size_t hashes[BATCH];
+        for (size_t start = 0; start < keys.size(); start += BATCH) {
+            size_t n = std::min(BATCH, keys.size() - start);
+            batch_hasher(keys.subspan(start, n), std::span<size_t>(hashes, n));
+            for (size_t i = 0; i < n; i++)
+                __builtin_prefetch(&table[mod_capacity(hashes[i])]);
+            for (size_t i = 0; i < n; i++)
+                values[start + i] = find(table[mod_capacity(hashes[i])], keys[start + i]);
         }
-        return nullptr;
+    }
+
+    // node sizes assume libstdc++: a list node adds two links, a tree node a colour and three links
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity;
+        usage.arrays = slot_bytes<Bucket>(capacity, memory_policy);
+        for (size_t i = 0; i < capacity; i++) {
+            for (const Entry& e : table[i].chain) {
+                usage.nodes += 2 * sizeof(void*) + sizeof(Entry);
+                usage.key_storage += heap_bytes(e.key);
+                usage.value_storage += heap_bytes(e.value);
+            }
+            if (table[i].tree) {
+                usage.nodes += sizeof(std::map<K, V>);
+                for (const auto& [key, value] : *table[i].tree) {
+                    usage.nodes += 4 * sizeof(void*) + sizeof(std::pair<const K, V>);
+                    usage.key_storage += heap_bytes(key);
+                    usage.value_storage += heap_bytes(value);
+                }
+            }
+        }
+        return usage;
+    }
+
+    // copies the entries into a compact read-only FrozenHashTable; this table is left as is and
+    // can be dropped once the frozen copy has been built
+    FrozenHashTable<K, V> freeze() const {
+        std::function<size_t(const K&, size_t)> frozen_hasher = hasher;
+        if (seeded_hasher) {
+            frozen_hasher = [f = seeded_hasher, s = seed](const K& key, size_t cap) { return f(key, cap, s); };
+        }
+        return FrozenHashTable<K, V>(size, std::move(frozen_hasher), [this](auto&& emit) {
+            for (size_t i = 0; i < capacity; i++) {
+                for (const Entry& e : table[i].chain)
+                    emit(e.key, e.value);
+                if (table[i].tree) {
+                    for (const auto& [key, value] : *table[i].tree)
+                        emit(key, value);
+                }
+            }
+        });
     }
 
     void print() const override {
         for (size_t i = 0; i < capacity; i++) {
             std::cout << "[" << i << "]: ";
-            for (const Entry& e : table[i])
+            for (const Entry& e : table[i].chain)
                 std::cout << "(" << e.key << "," << e.value << ") ";
+            if (table[i].tree) {
+                for (const auto& [key, value] : *table[i].tree)
+                    std::cout << "(" << key << "," << value << ") ";
+            }
             std::cout << "\n";
         }
     }
@@ -0,0 +1 @@
+#include "ConcurrentHashTable.h"
\ No newline at end of file
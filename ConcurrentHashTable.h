@@ -0,0 +1,206 @@
+#ifndef P3_CONCURRENTHASHTABLE_H
+#define P3_CONCURRENTHASHTABLE_H
+#pragma once
+
+#include "HashTable.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+// Thread-safe chaining table with per-bucket locks. Growing does not stop the world: a resize
+// installs a second bucket array and threads claim MIGRATION_CHUNK old buckets at a time to move
+// over. Until a bucket has moved it is served from the old array, afterwards operations follow
+// the forwarding pointer to the new one, so readers only ever wait for a single bucket.
+// Values are returned by copy since entries move between arrays. The table only grows.
+template<typename K, typename V>
+class ConcurrentHashTable {
+private:
+    static constexpr size_t MIGRATION_CHUNK = 64;
+
+    struct Entry {
+        K key;
+        V value;
+    };
+
+    struct Bucket {
+        std::mutex lock;
+        std::list<Entry> chain;
+        bool moved = false;
+    };
+
+    struct Array {
+        size_t capacity;
+        std::unique_ptr<Bucket[]> buckets;
+        std::atomic<Array*> next{ nullptr };
+        std::atomic<size_t> claim_cursor{ 0 };
+        std::atomic<size_t> migrated{ 0 };
+
+        explicit Array(size_t cap) : capacity(cap), buckets(new Bucket[cap]) {}
+    };
+
+    std::atomic<Array*> current;
+    std::atomic<size_t> size{ 0 };
+    std::function<size_t(const K&, size_t)> hasher;
+
+    // arrays replaced by a resize stay allocated until the table is destroyed, because readers
+    // may still hold a pointer to them; their chains are already empty
+    std::mutex retired_lock;
+    std::vector<std::unique_ptr<Array>> arrays;
+
+    Bucket& bucket_for(Array* array, const K& key) const {
+        return array->buckets[hasher(key, array->capacity) % array->capacity];
+    }
+
+    void start_resize(Array* array) {
+        if (array->next.load() != nullptr) return;
+
+        std::lock_guard<std::mutex> guard(retired_lock);
+        if (array->next.load() != nullptr || current.load() != array) return;
+        arrays.push_back(std::make_unique<Array>(next_table_prime(array->capacity * 2)));
+        array->next.store(arrays.back().get());
+    }
+
+    void migrate_bucket(Array* from, Array* to, size_t index) {
+        Bucket& old_bucket = from->buckets[index];
+        std::lock_guard<std::mutex> old_guard(old_bucket.lock);
+        for (Entry& e : old_bucket.chain) {
+            Bucket& new_bucket = bucket_for(to, e.key);
+            std::lock_guard<std::mutex> new_guard(new_bucket.lock);
+            new_bucket.chain.push_back(std::move(e));
+        }
+        old_bucket.chain.clear();
+        old_bucket.moved = true;
+    }
+
+    // claims and migrates chunks of `from` until none are left; the thread that completes the
+    // last chunk publishes the new array
+    void help_migrate(Array* from) {
+        Array* to = from->next.load();
+        if (to == nullptr) return;
+
+        while (true) {
+            size_t begin = from->claim_cursor.fetch_add(MIGRATION_CHUNK);
+            if (begin >= from->capacity) return;
+            size_t end = std::min(begin + MIGRATION_CHUNK, from->capacity);
+            for (size_t i = begin; i < end; i++)
+                migrate_bucket(from, to, i);
+
+            if (from->migrated.fetch_add(end - begin) + (end - begin) == from->capacity) {
+                Array* expected = from;
+                current.compare_exchange_strong(expected, to);
+            }
+        }
+    }
+
+public:
+    explicit ConcurrentHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc)
+            : hasher(std::move(hashFunc)) {
+        arrays.push_back(std::make_unique<Array>(next_prime(initial_capacity)));
+        current.store(arrays.back().get());
+    }
+
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+    void insert(const K& key, const V& value) {
+        Array* array = current.load();
+        while (true) {
+            Bucket& bucket = bucket_for(array, key);
+            std::unique_lock<std::mutex> guard(bucket.lock);
+            if (bucket.moved) {
+                guard.unlock();
+                help_migrate(array);
+                array = array->next.load();
+                continue;
+            }
+
+            for (Entry& e : bucket.chain) {
+                if (e.key == key) {
+                    e.value = value;
+                    return;
+                }
+            }
+            bucket.chain.push_back({ key, value });
+            break;
+        }
+
+        if ((size.fetch_add(1) + 1) * 2 > array->capacity)
+            start_resize(current.load());
+        Array* resizing = current.load();
+        if (resizing->next.load() != nullptr)
+            help_migrate(resizing);
+    }
+
+    bool remove(const K& key) {
+        Array* array = current.load();
+        while (true) {
+            Bucket& bucket = bucket_for(array, key);
+            std::unique_lock<std::mutex> guard(bucket.lock);
+            if (bucket.moved) {
+                guard.unlock();
+                help_migrate(array);
+                array = array->next.load();
+                continue;
+            }
+
+            for (auto it = bucket.chain.begin(); it != bucket.chain.end(); it++) {
+                if (it->key == key) {
+                    bucket.chain.erase(it);
+                    size.fetch_sub(1);
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    // readers never migrate; they only follow forwarding pointers
+    std::optional<V> getValue(const K& key) const {
+        Array* array = current.load();
+        while (true) {
+            Bucket& bucket = bucket_for(array, key);
+            std::lock_guard<std::mutex> guard(bucket.lock);
+            if (bucket.moved) {
+                array = array->next.load();
+                continue;
+            }
+            for (const Entry& e : bucket.chain) {
+                if (e.key == key)
+                    return e.value;
+            }
+            return std::nullopt;
+        }
+    }
+
+    // lets a dedicated helper thread assist an in-progress resize; returns false when none is running
+    bool help_resize() {
+        Array* array = current.load();
+        if (array->next.load() == nullptr) return false;
+        help_migrate(array);
+        return true;
+    }
+
+    size_t count() const {
+        return size.load();
+    }
+
+    void print() const {
+        Array* array = current.load();
+        for (size_t i = 0; i < array->capacity; i++) {
+            Bucket& bucket = array->buckets[i];
+            std::lock_guard<std::mutex> guard(bucket.lock);
+            std::cout << "[" << i << "]: ";
+            for (const Entry& e : bucket.chain)
+                std::cout << "(" << e.key << "," << e.value << ") ";
+            std::cout << "\n";
+        }
+    }
+};
+
+#endif //P3_CONCURRENTHASHTABLE_H
@@ -0,0 +1 @@
+#include "CuckooHashTable.h"
\ No newline at end of file
@@ -0,0 +1,302 @@
+#ifndef P3_CUCKOOHASHTABLE_H
+#define P3_CUCKOOHASHTABLE_H
+#pragma once
+
+#include "HashTable.h"
+#include "memory_policy.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Bucketized cuckoo hashing: every key lives in one of two 4-way buckets or in a small stash.
+// Each bucket's 32-bit fingerprints sit in a 16-byte header apart from the entries, so a lookup
+// reads at most two headers and touches an entry only on a fingerprint match.
+template<typename K, typename V>
+class CuckooHashTable : protected HashTable<K, V> {
+private:
+    static constexpr size_t SLOTS_PER_BUCKET = 4;
+    static constexpr size_t MAX_DISPLACEMENTS = 256;
+    static constexpr size_t MAX_STASH = 4;
+    static constexpr double MAX_LOAD = 0.9;
+
+    struct Entry {
+        K key;
+        V value;
+    };
+
+    // fingerprint 0 marks an empty slot; an entry in its alternate bucket has ALTERNATE set
+    static constexpr uint32_t ALTERNATE = 0x80000000u;
+
+    struct alignas(16) Bucket {
+        uint32_t tags[SLOTS_PER_BUCKET] = {};
+    };
+
+    // where a key may live: its primary bucket and the fingerprint, ALTERNATE clear, that also
+    // picks the alternate
+    struct Location {
+        size_t bucket;
+        uint32_t tag;
+    };
+
+    Bucket* table;
+    Entry* slots;      // SLOTS_PER_BUCKET entries per bucket
+    size_t capacity;   // number of buckets
+    size_t min_capacity;
+    size_t size;
+    std::function<size_t(const K&, size_t)> hasher;
+    MemoryPolicy memory_policy;
+    std::vector<Entry> stash;
+    uint64_t walk_state = 0x9e3779b97f4a7c15ULL;
+
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    static size_t mix(size_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // the one hasher call of an operation; the fingerprint also mixes in std::hash so keys a weak
+    // hasher maps to the same value still spread over different alternate buckets
+    Location locate(const K& key) const {
+        size_t hash = hasher(key, capacity);
+        uint32_t tag = static_cast<uint32_t>(mix(hash ^ std::hash<K>{}(key)) >> 33);
+        return { hash % capacity, tag == 0 ? 1u : tag };
+    }
+
+    // the other bucket of an entry with fingerprint `tag` in `bucket`, computed from the
+    // fingerprint alone so a displaced entry moves without its key being hashed again; the
+    // alternate is the primary plus an offset in [1, capacity), never the primary itself, and
+    // ALTERNATE says which way to step, so flipping it after each move makes the map its own inverse
+    size_t other_bucket(size_t bucket, uint32_t tag) const {
+        size_t offset = 1 + mix(tag & ~ALTERNATE) % (capacity - 1);
+        return tag & ALTERNATE ? (bucket + capacity - offset) % capacity : (bucket + offset) % capacity;
+    }
+
+    // slot index of key in bucket, or NOT_FOUND
+    size_t find_in(size_t bucket, uint32_t tag, const K& key) const {
+        const Bucket& b = table[bucket];
+        for (size_t s = 0; s < SLOTS_PER_BUCKET; s++) {
+            if (b.tags[s] == tag && slots[bucket * SLOTS_PER_BUCKET + s].key == key)
+                return bucket * SLOTS_PER_BUCKET + s;
+        }
+        return NOT_FOUND;
+    }
+
+    size_t find_slot(const K& key, Location loc) const {
+        size_t slot = find_in(loc.bucket, loc.tag, key);
+        return slot != NOT_FOUND ? slot : find_in(other_bucket(loc.bucket, loc.tag), loc.tag | ALTERNATE, key);
+    }
+
+    Entry* find(const K& key) const {
+        size_t slot = find_slot(key, locate(key));
+        if (slot != NOT_FOUND) return &slots[slot];
+        for (const Entry& e : stash) {
+            if (e.key == key) return const_cast<Entry*>(&e);
+        }
+        return nullptr;
+    }
+
+    bool place_free(size_t bucket, uint32_t tag, Entry& entry) {
+        Bucket& b = table[bucket];
+        for (size_t s = 0; s < SLOTS_PER_BUCKET; s++) {
+            if (b.tags[s] == 0) {
+                slots[bucket * SLOTS_PER_BUCKET + s] = std::move(entry);
+                b.tags[s] = tag;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // places a key known to be absent; on failure the homeless entry is left in `entry`
+    bool place(Entry& entry, Location loc) {
+        size_t bucket = loc.bucket;
+        uint32_t tag = loc.tag;
+        if (place_free(bucket, tag, entry)) return true;
+        bucket = other_bucket(bucket, tag);
+        tag ^= ALTERNATE;
+        if (place_free(bucket, tag, entry)) return true;
+
+        for (size_t d = 0; d < MAX_DISPLACEMENTS; d++) {
+            walk_state ^= walk_state << 13;
+            walk_state ^= walk_state >> 7;
+            walk_state ^= walk_state << 17;
+            size_t victim = walk_state % SLOTS_PER_BUCKET;
+
+            std::swap(entry, slots[bucket * SLOTS_PER_BUCKET + victim]);
+            std::swap(tag, table[bucket].tags[victim]);
+            bucket = other_bucket(bucket, tag);
+            tag ^= ALTERNATE;
+            if (place_free(bucket, tag, entry)) return true;
+        }
+        if (stash.size() < MAX_STASH) {
+            stash.push_back(std::move(entry));
+            return true;
+        }
+        return false;
+    }
+
+    void rehash(size_t new_capacity) {
+        std::vector<Entry> entries;
+        entries.reserve(size);
+        for (size_t i = 0; i < capacity; i++) {
+            for (size_t s = 0; s < SLOTS_PER_BUCKET; s++) {
+                if (table[i].tags[s] != 0)
+                    entries.push_back(std::move(slots[i * SLOTS_PER_BUCKET + s]));
+            }
+        }
+        for (Entry& e : stash)
+            entries.push_back(std::move(e));
+
+        while (true) {
+            release_slots(table, capacity, memory_policy);
+            release_slots(slots, capacity * SLOTS_PER_BUCKET, memory_policy);
+            table = allocate_slots<Bucket>(new_capacity, memory_policy);
+            slots = allocate_slots<Entry>(new_capacity * SLOTS_PER_BUCKET, memory_policy);
+            capacity = new_capacity;
+            stash.clear();
+
+            size_t placed = 0;
+            for (; placed < entries.size(); placed++) {
+                Entry copy = entries[placed];
+                if (!place(copy, locate(copy.key))) break;
+            }
+            if (placed == entries.size()) return;
+            new_capacity = next_table_prime(new_capacity * 2);
+        }
+    }
+
+    void rehash_up() override {
+        rehash(next_table_prime(capacity * 2));
+    }
+
+    void rehash_down() override {
+        if (capacity <= min_capacity) return;
+
+        size_t new_capacity = previous_table_prime(capacity / 2);
+        if (new_capacity < min_capacity) {
+            new_capacity = min_capacity;
+        }
+        rehash(new_capacity);
+    }
+
+public:
+    explicit CuckooHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc,
+                             MemoryPolicy policy = {})
+            : capacity(next_prime(initial_capacity / SLOTS_PER_BUCKET + 1)),
+              min_capacity(next_prime(initial_capacity / SLOTS_PER_BUCKET + 1)), size(0),
+              hasher(std::move(hashFunc)), memory_policy(policy) {
+        table = allocate_slots<Bucket>(capacity, memory_policy);
+        slots = allocate_slots<Entry>(capacity * SLOTS_PER_BUCKET, memory_policy);
+    }
+
+    ~CuckooHashTable() {
+        release_slots(table, capacity, memory_policy);
+        release_slots(slots, capacity * SLOTS_PER_BUCKET, memory_policy);
+    }
+
+    void insert(const K& key, const V& value) override {
+        Location loc = locate(key);
+        size_t slot = find_slot(key, loc);
+        if (slot != NOT_FOUND) {
+            slots[slot].value = value;
+            return;
+        }
+        for (Entry& e : stash) {
+            if (e.key == key) {
+                e.value = value;
+                return;
+            }
+        }
+        if (size + 1 > MAX_LOAD * capacity * SLOTS_PER_BUCKET) {
+            rehash_up();
+            loc = locate(key);
+        }
+
+        Entry entry{ key, value };
+        while (!place(entry, loc)) {
+            // the displacement walk failed with a full stash; grow and retry the homeless entry
+            rehash_up();
+            loc = locate(entry.key);
+        }
+        size++;
+    }
+
+    bool remove(const K& key) override {
+        size_t slot = find_slot(key, locate(key));
+        if (slot != NOT_FOUND) {
+            table[slot / SLOTS_PER_BUCKET].tags[slot % SLOTS_PER_BUCKET] = 0;
+            size--;
+            if (size < capacity * SLOTS_PER_BUCKET / 4)
+                rehash_down();
+            return true;
+        }
+        for (auto it = stash.begin(); it != stash.end(); it++) {
+            if (it->key == key) {
+                stash.erase(it);
+                size--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // clears the fingerprints and the stash, keeping the bucket and entry arrays
+    void clear() {
+        std::fill(table, table + capacity, Bucket{});
+        stash.clear();
+        size = 0;
+    }
+
+    // rehashes into the fewest buckets that hold the current entries at MAX_LOAD, but not below
+    // the initial number
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_prime(static_cast<size_t>(size / (MAX_LOAD * SLOTS_PER_BUCKET)) + 1));
+        if (fitted < capacity) rehash(fitted);
+    }
+
+    V* getValue(const K& key) const override {
+        Entry* e = find(key);
+        return e ? &e->value : nullptr;
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity * SLOTS_PER_BUCKET;
+        usage.arrays = slot_bytes<Bucket>(capacity, memory_policy) +
+                       slot_bytes<Entry>(capacity * SLOTS_PER_BUCKET, memory_policy);
+        usage.nodes = stash.capacity() * sizeof(Entry);
+        for (size_t i = 0; i < capacity * SLOTS_PER_BUCKET; i++) {
+            usage.key_storage += heap_bytes(slots[i].key);
+            usage.value_storage += heap_bytes(slots[i].value);
+        }
+        for (const Entry& e : stash) {
+            usage.key_storage += heap_bytes(e.key);
+            usage.value_storage += heap_bytes(e.value);
+        }
+        return usage;
+    }
+
+    void print() const override {
+        for (size_t i = 0; i < capacity; i++) {
+            std::cout << "[" << i << "]: ";
+            for (size_t s = 0; s < SLOTS_PER_BUCKET; s++) {
+                const Entry& e = slots[i * SLOTS_PER_BUCKET + s];
+                if (table[i].tags[s] != 0)
+                    std::cout << "(" << e.key << "," << e.value << ") ";
+            }
+            std::cout << "\n";
+        }
+        std::cout << "[stash]: ";
+        for (const Entry& e : stash)
+            std::cout << "(" << e.key << "," << e.value << ") ";
+        std::cout << "\n";
+    }
+};
+
+#endif //P3_CUCKOOHASHTABLE_H
@@ -0,0 +1 @@
+#include "FrozenHashTable.h"
\ No newline at end of file
@@ -0,0 +1,165 @@
+#ifndef P3_FROZENHASHTABLE_H
+#define P3_FROZENHASHTABLE_H
+#pragma once
+
+#include "hash_functions.h"
+#include "memory_policy.h"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Immutable table produced by freeze() once a table is done loading. Entries are sorted by
+// bucket into one flat array and bucket b owns slots [bucket_start[b], bucket_start[b + 1]), so
+// there are no per-slot states, no list nodes and no empty slots, at one bucket per entry. Each
+// slot keeps 32 bits of its hash as a tag that rejects almost every mismatch before the key is
+// touched, and std::string keys are packed end to end into one character arena.
+template<typename K, typename V>
+class FrozenHashTable {
+private:
+    static constexpr bool ARENA_KEYS = std::is_same_v<K, std::string>;
+
+    // arena keys store their start offset; a key ends where the next slot's key starts
+    struct Slot {
+        uint32_t tag;
+        std::conditional_t<ARENA_KEYS, uint32_t, K> key;
+        V value;
+    };
+
+    std::vector<uint32_t> bucket_start;
+    std::vector<Slot> slots;
+    std::vector<char> arena;
+    std::function<size_t(const K&, size_t)> hasher;
+
+    uint64_t hash(const K& key) const {
+        return IntegerMixHash()(hasher(key, bucket_start.size() - 1));
+    }
+
+    size_t bucket(uint64_t h) const {
+        return ((h >> 32) * (bucket_start.size() - 1)) >> 32;
+    }
+
+    size_t key_end(size_t i) const {
+        return i + 1 < slots.size() ? slots[i + 1].key : arena.size();
+    }
+
+    bool key_equals(size_t i, const K& key) const {
+        if constexpr (ARENA_KEYS) {
+            size_t length = key_end(i) - slots[i].key;
+            return key.size() == length && memcmp(arena.data() + slots[i].key, key.data(), length) == 0;
+        } else {
+            return slots[i].key == key;
+        }
+    }
+
+    K key_at(size_t i) const {
+        if constexpr (ARENA_KEYS)
+            return K(arena.data() + slots[i].key, key_end(i) - slots[i].key);
+        else
+            return slots[i].key;
+    }
+
+public:
+    // for_each(emit) must call emit(key, value) for every entry, the same way both times it runs;
+    // `expected` sizes the table and must be at least the number of entries
+    template<typename ForEach>
+    FrozenHashTable(size_t expected, std::function<size_t(const K&, size_t)> hashFunc, ForEach&& for_each)
+            : hasher(std::move(hashFunc)) {
+        size_t num_buckets = expected > 0 ? expected : 1;
+        if (num_buckets >= std::numeric_limits<uint32_t>::max())
+            throw std::overflow_error("FrozenHashTable is limited to 2^32 entries");
+        bucket_start.assign(num_buckets + 1, 0);
+
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> lengths;
+        hashes.reserve(expected);
+        for_each([&](const K& key, const V&) {
+            hashes.push_back(hash(key));
+            if constexpr (ARENA_KEYS) lengths.push_back(static_cast<uint32_t>(key.size()));
+        });
+        size_t n = hashes.size();
+        if (n > expected)
+            throw std::overflow_error("FrozenHashTable saw more entries than expected");
+
+        // counting sort by bucket: count, prefix sum, then hand out positions
+        for (uint64_t h : hashes)
+            bucket_start[bucket(h) + 1]++;
+        for (size_t b = 0; b < num_buckets; b++)
+            bucket_start[b + 1] += bucket_start[b];
+        std::vector<uint32_t> cursor(bucket_start.begin(), bucket_start.end() - 1);
+        std::vector<uint32_t> position(n);
+        slots.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            position[i] = cursor[bucket(hashes[i])]++;
+            slots[position[i]].tag = static_cast<uint32_t>(hashes[i]);
+        }
+
+        if constexpr (ARENA_KEYS) {
+            std::vector<uint32_t> sorted_lengths(n);
+            for (size_t i = 0; i < n; i++)
+                sorted_lengths[position[i]] = lengths[i];
+            uint64_t total = 0;
+            for (size_t i = 0; i < n; i++) {
+                slots[i].key = static_cast<uint32_t>(total);
+                total += sorted_lengths[i];
+                if (total > std::numeric_limits<uint32_t>::max())
+                    throw std::overflow_error("FrozenHashTable key arena is limited to 4 GiB");
+            }
+            arena.resize(total);
+        }
+
+        size_t i = 0;
+        for_each([&](const K& key, const V& value) {
+            Slot& slot = slots[position[i++]];
+            if constexpr (ARENA_KEYS)
+                memcpy(arena.data() + slot.key, key.data(), key.size());
+            else
+                slot.key = key;
+            slot.value = value;
+        });
+    }
+
+    const V* getValue(const K& key) const {
+        uint64_t h = hash(key);
+        uint32_t tag = static_cast<uint32_t>(h);
+        size_t b = bucket(h);
+        for (size_t i = bucket_start[b]; i < bucket_start[b + 1]; i++) {
+            if (slots[i].tag == tag && key_equals(i, key))
+                return &slots[i].value;
+        }
+        return nullptr;
+    }
+
+    size_t count() const {
+        return slots.size();
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = slots.size();
+        usage.slots = slots.size();
+        usage.arrays = bucket_start.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(Slot);
+        usage.key_storage = arena.capacity();
+        for (const Slot& slot : slots) {
+            if constexpr (!ARENA_KEYS) usage.key_storage += heap_bytes(slot.key);
+            usage.value_storage += heap_bytes(slot.value);
+        }
+        return usage;
+    }
+
+    void print() const {
+        for (size_t b = 0; b + 1 < bucket_start.size(); b++) {
+            std::cout << "[" << b << "]: ";
+            for (size_t i = bucket_start[b]; i < bucket_start[b + 1]; i++)
+                std::cout << "(" << key_at(i) << "," << slots[i].value << ") ";
+            std::cout << "\n";
+        }
+    }
+};
+
+#endif //P3_FROZENHASHTABLE_H
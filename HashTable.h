@@ -2,10 +2,29 @@
 #define P3_HASHTABLE_H
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <list>
 #include <functional>
+#include <cstdint>
 
-enum class EntryState { EMPTY, OCCUPIED, DELETED };
+enum class EntryState : uint8_t { EMPTY, OCCUPIED, DELETED };
+
+// size budget for tables used as caches; a zero limit is not enforced
+template<typename K, typename V>
+struct CacheLimits {
+    size_t max_entries = 0;
+    size_t max_bytes = 0;
+    std::function<size_t(const K&, const V&)> entry_bytes;
+
+    bool enabled() const { return max_entries != 0 || max_bytes != 0; }
+};
+
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
 
 inline bool is_prime(size_t n) {
     if (n < 2) return false;
@@ -14,6 +33,34 @@ inline bool is_prime(size_t n) {
     return true;
 }
 
+// growth table for prime capacities: the smallest prime >= 2^(k/4), so consecutive capacities
+// are about 19% apart and doubling a capacity lands four entries further on
+inline constexpr size_t PRIME_CAPACITIES[] = {
+    2, 3, 5, 7, 11, 13, 17, 23, 29, 37, 41, 47, 59, 67, 79, 97, 109, 131, 157, 191, 223, 257, 307,
+    367, 431, 521, 613, 727, 863, 1031, 1223, 1451, 1723, 2053, 2437, 2897, 3449, 4099, 4871, 5801,
+    6899, 8209, 9743, 11587, 13781, 16411, 19489, 23173, 27581, 32771, 38971, 46349, 55109, 65537,
+    77951, 92683, 110221, 131101, 155887, 185369, 220447, 262147, 311747, 370759, 440893, 524309,
+    623521, 741457, 881779, 1048583, 1246997, 1482919, 1763491, 2097169, 2493949, 2965847, 3526987,
+    4194319, 4987901, 5931649, 7053971, 8388617, 9975803, 11863289, 14107921, 16777259, 19951597,
+    23726569, 28215809, 33554467, 39903197, 47453149, 56431657, 67108879, 79806341, 94906297,
+    112863217, 134217757, 159612679, 189812533, 225726419, 268435459, 319225391, 379625083,
+    451452839, 536870923, 638450719, 759250133, 902905657, 1073741827, 1276901429, 1518500279,
+    1805811341, 2147483659, 2553802871, 3037000507, 3611622607, 4294967311ULL, 5107605691ULL,
+    6074001001ULL, 7223245229ULL, 8589934609ULL, 10215211387ULL, 12148002047ULL, 14446490449ULL,
+    17179869209ULL, 20430422699ULL, 24296004011ULL, 28892980877ULL, 34359738421ULL, 40860845437ULL,
+    48592008053ULL, 57785961671ULL, 68719476767ULL, 81721690807ULL, 97184016049ULL, 115571923303ULL,
+    137438953481ULL, 163443381373ULL, 194368032011ULL, 231143846587ULL, 274877906951ULL,
+    326886762733ULL, 388736063999ULL, 462287693167ULL, 549755813911ULL, 653773525393ULL,
+    777472128049ULL, 924575386373ULL, 1099511627791ULL, 1307547050819ULL, 1554944255989ULL,
+    1849150772699ULL, 2199023255579ULL, 2615094101561ULL, 3109888512037ULL, 3698301545321ULL,
+    4398046511119ULL, 5230188203153ULL, 6219777023959ULL, 7396603090651ULL, 8796093022237ULL,
+    10460376406273ULL, 12439554047911ULL, 14793206181251ULL, 17592186044423ULL, 20920752812489ULL,
+    24879108095833ULL, 29586412362491ULL, 35184372088891ULL, 41841505624973ULL, 49758216191633ULL,
+    59172824724919ULL, 70368744177679ULL, 83683011249917ULL, 99516432383281ULL, 118345649449813ULL,
+    140737488355333ULL, 167366022499847ULL, 199032864766447ULL, 236691298899683ULL,
+    281474976710677ULL
+};
+
 inline size_t next_prime(size_t n) {
     while (!is_prime(n)) n++;
     return n;
@@ -27,6 +74,38 @@ inline size_t previous_prime(size_t n) {
     return n;
 }
 
+// smallest table prime >= n, for growth steps; capacities a caller asks for use next_prime
+inline size_t next_table_prime(size_t n) {
+    const size_t* it = std::lower_bound(std::begin(PRIME_CAPACITIES), std::end(PRIME_CAPACITIES), n);
+    return it != std::end(PRIME_CAPACITIES) ? *it : next_prime(n);
+}
+
+// largest table prime < n, or 2, for shrink steps
+inline size_t previous_table_prime(size_t n) {
+    const size_t* it = std::lower_bound(std::begin(PRIME_CAPACITIES), std::end(PRIME_CAPACITIES), n);
+    if (it == std::end(PRIME_CAPACITIES)) return previous_prime(n);
+    return it == std::begin(PRIME_CAPACITIES) ? 2 : *(it - 1);
+}
+
+// Lemire's fastmod: n % divisor as two wide multiplications with a reciprocal computed once per
+// divisor, exact for every 64-bit n and divisor
+class FastMod {
+private:
+    __uint128_t reciprocal = 0;
+    uint64_t divisor = 1;
+
+public:
+    FastMod() = default;
+    explicit FastMod(uint64_t d) : reciprocal(~__uint128_t(0) / d + 1), divisor(d) {}
+
+    uint64_t operator()(uint64_t n) const {
+        __uint128_t fraction = reciprocal * n;
+        __uint128_t low = static_cast<uint64_t>(fraction) * static_cast<__uint128_t>(divisor);
+        __uint128_t high = static_cast<uint64_t>(fraction >> 64) * static_cast<__uint128_t>(divisor);
+        return static_cast<uint64_t>((high + (low >> 64)) >> 64);
+    }
+};
+
 template<typename K, typename V>
 class HashTable {
 protected:
@@ -40,7 +119,7 @@ protected:
     virtual void rehash_down() = 0;
 public:
     HashTable() = default;
-    ~HashTable() = default;
+    virtual ~HashTable() = default;
 
     virtual void insert(const K& key, const V& value) = 0;
     virtual bool remove(const K& key) = 0;
@@ -0,0 +1 @@
+#include "HopscotchHashTable.h"
\ No newline at end of file
@@ -0,0 +1,295 @@
+#ifndef P3_HOPSCOTCHHASHTABLE_H
+#define P3_HOPSCOTCHHASHTABLE_H
+#pragma once
+
+#include "HashTable.h"
+#include "memory_policy.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Hopscotch hashing: every key is kept within NEIGHBORHOOD slots of its home bucket and each
+// home bucket records in a bitmap which of those slots hold its keys, so a lookup checks at
+// most NEIGHBORHOOD slots, even at load factors above 0.9. Keys a sparse table cannot place
+// because too many share a home (weak hashers) go to an overflow store sorted by key, which
+// costs a lookup one binary search, and only when the neighborhood misses.
+template<typename K, typename V>
+class HopscotchHashTable : protected HashTable<K, V> {
+private:
+    static constexpr size_t NEIGHBORHOOD = 64;
+    static constexpr size_t MAX_FREE_SEARCH = 1024;
+    static constexpr double MAX_LOAD = 0.9;
+    static constexpr double MIN_GROW_LOAD = 0.5;
+
+    struct Entry {
+        K key;
+        V value;
+        EntryState state = EntryState::EMPTY;
+    };
+
+    Entry* table;
+    uint64_t* hop_info;
+    size_t capacity;
+    size_t min_capacity;
+    size_t size;
+    std::function<size_t(const K&, size_t)> hasher;
+    MemoryPolicy memory_policy;
+    // keys whose neighborhood is saturated by colliding hashes while the table is still sparse,
+    // where growing would not help; kept sorted by key
+    std::vector<Entry> overflow;
+
+    // the hasher output is remixed because structured outputs (DJB2 over sequential keys) pack
+    // more than NEIGHBORHOOD homes into a window long before the table is full
+    size_t home(const K& key) const {
+        size_t h = hasher(key, capacity);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h % capacity;
+    }
+
+    size_t distance(size_t from, size_t to) const {
+        return (to + capacity - from) % capacity;
+    }
+
+    void allocate(size_t new_capacity) {
+        table = allocate_slots<Entry>(new_capacity, memory_policy);
+        hop_info = allocate_slots<uint64_t>(new_capacity, memory_policy);
+        for (size_t i = 0; i < new_capacity; i++)
+            hop_info[i] = 0;
+        capacity = new_capacity;
+    }
+
+    void rehash(size_t new_capacity) {
+        Entry* old_table = table;
+        uint64_t* old_hop_info = hop_info;
+        size_t old_capacity = capacity;
+
+        allocate(new_capacity);
+        size = 0;
+
+        std::vector<Entry> old_overflow = std::move(overflow);
+        overflow.clear();
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_table[i].state == EntryState::OCCUPIED) {
+                reinsert(old_table[i].key, old_table[i].value);
+            }
+        }
+        for (const Entry& e : old_overflow)
+            reinsert(e.key, e.value);
+        std::sort(overflow.begin(), overflow.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+        release_slots(old_table, old_capacity, memory_policy);
+        release_slots(old_hop_info, old_capacity, memory_policy);
+    }
+
+    void rehash_up() override {
+        rehash(next_table_prime(capacity * 2));
+    }
+
+    void rehash_down() override {
+        if (capacity <= min_capacity) return;
+
+        size_t new_capacity = previous_table_prime(capacity / 2);
+        if (new_capacity < min_capacity) {
+            new_capacity = min_capacity;
+        }
+        rehash(new_capacity);
+    }
+
+    size_t find(const K& key) const {
+        size_t bucket = home(key);
+        uint64_t bits = hop_info[bucket];
+        while (bits) {
+            size_t offset = __builtin_ctzll(bits);
+            size_t index = (bucket + offset) % capacity;
+            if (table[index].key == key) return index;
+            bits &= bits - 1;
+        }
+        return capacity;
+    }
+
+    // first overflow entry whose key is not less than `key`
+    typename std::vector<Entry>::iterator overflow_bound(const K& key) const {
+        auto& store = const_cast<std::vector<Entry>&>(overflow);
+        return std::lower_bound(store.begin(), store.end(), key,
+                                [](const Entry& e, const K& k) { return e.key < k; });
+    }
+
+    Entry* find_overflow(const K& key) const {
+        auto it = overflow_bound(key);
+        return it != overflow.end() && it->key == key ? &*it : nullptr;
+    }
+
+    // moves some entry closer to its home so that `free_slot` ends up nearer; returns the
+    // new free slot or capacity when nothing in range can move
+    size_t hop_closer(size_t free_slot) {
+        for (size_t back = NEIGHBORHOOD - 1; back > 0; back--) {
+            size_t bucket = (free_slot + capacity - back) % capacity;
+            uint64_t bits = hop_info[bucket];
+            if (bits == 0) continue;
+
+            size_t offset = __builtin_ctzll(bits);
+            if (offset >= back) continue;
+            size_t from = (bucket + offset) % capacity;
+            table[free_slot] = std::move(table[from]);
+            table[from].state = EntryState::EMPTY;
+            hop_info[bucket] &= ~(1ull << offset);
+            hop_info[bucket] |= 1ull << back;
+            return from;
+        }
+        return capacity;
+    }
+
+    // places a key known to be absent; returns false when the neighborhood cannot take it
+    bool place(const K& key, const V& value) {
+        size_t bucket = home(key);
+        size_t free_slot = capacity;
+        size_t limit = capacity < MAX_FREE_SEARCH ? capacity : MAX_FREE_SEARCH;
+        for (size_t i = 0; i < limit; i++) {
+            size_t index = (bucket + i) % capacity;
+            if (table[index].state != EntryState::OCCUPIED) {
+                free_slot = index;
+                break;
+            }
+        }
+        if (free_slot == capacity) return false;
+
+        while (distance(bucket, free_slot) >= NEIGHBORHOOD) {
+            free_slot = hop_closer(free_slot);
+            if (free_slot == capacity) return false;
+        }
+
+        table[free_slot] = { key, value, EntryState::OCCUPIED };
+        hop_info[bucket] |= 1ull << distance(bucket, free_slot);
+        size++;
+        return true;
+    }
+
+    // places an entry the table already held; one the new capacity cannot place is appended to
+    // the overflow store, which rehash sorts once all entries are in
+    void reinsert(const K& key, const V& value) {
+        if (!place(key, value)) {
+            overflow.push_back({ key, value, EntryState::OCCUPIED });
+            size++;
+        }
+    }
+
+public:
+    explicit HopscotchHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc,
+                                MemoryPolicy policy = {})
+            : capacity(0), min_capacity(next_prime(initial_capacity < NEIGHBORHOOD ? NEIGHBORHOOD : initial_capacity)),
+              size(0), hasher(std::move(hashFunc)), memory_policy(policy) {
+        allocate(min_capacity);
+    }
+
+    ~HopscotchHashTable() {
+        release_slots(table, capacity, memory_policy);
+        release_slots(hop_info, capacity, memory_policy);
+    }
+
+    void insert(const K& key, const V& value) override {
+        size_t index = find(key);
+        if (index != capacity) {
+            table[index].value = value;
+            return;
+        }
+        if (Entry* e = find_overflow(key)) {
+            e->value = value;
+            return;
+        }
+        if (size + 1 > MAX_LOAD * capacity)
+            rehash_up();
+        while (!place(key, value)) {
+            if (load_factor() < MIN_GROW_LOAD) {
+                overflow.insert(overflow_bound(key), { key, value, EntryState::OCCUPIED });
+                size++;
+                return;
+            }
+            rehash_up();
+        }
+    }
+
+    bool remove(const K& key) override {
+        size_t index = find(key);
+        if (index == capacity) {
+            auto it = overflow_bound(key);
+            if (it == overflow.end() || !(it->key == key)) return false;
+            overflow.erase(it);
+            size--;
+            return true;
+        }
+
+        size_t bucket = home(key);
+        table[index].state = EntryState::EMPTY;
+        hop_info[bucket] &= ~(1ull << distance(bucket, index));
+        size--;
+        if (size < capacity / 4 && capacity > min_capacity)
+            rehash_down();
+        return true;
+    }
+
+    // empties the slots, neighborhoods and overflow store, keeping the arrays
+    void clear() {
+        for (size_t i = 0; i < capacity; i++) {
+            table[i].state = EntryState::EMPTY;
+            hop_info[i] = 0;
+        }
+        overflow.clear();
+        size = 0;
+    }
+
+    // rehashes into the smallest capacity that holds the current entries, but not below the
+    // initial one
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_prime(size * 2));
+        if (fitted < capacity) rehash(fitted);
+    }
+
+    V* getValue(const K& key) const override {
+        size_t index = find(key);
+        if (index != capacity) return &table[index].value;
+        if (overflow.empty()) return nullptr;
+        Entry* e = find_overflow(key);
+        return e ? &e->value : nullptr;
+    }
+
+    double load_factor() const {
+        return static_cast<double>(size) / capacity;
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity;
+        usage.arrays = slot_bytes<Entry>(capacity, memory_policy) + slot_bytes<uint64_t>(capacity, memory_policy);
+        usage.nodes = overflow.capacity() * sizeof(Entry);
+        for (size_t i = 0; i < capacity; i++) {
+            usage.key_storage += heap_bytes(table[i].key);
+            usage.value_storage += heap_bytes(table[i].value);
+        }
+        for (const Entry& e : overflow) {
+            usage.key_storage += heap_bytes(e.key);
+            usage.value_storage += heap_bytes(e.value);
+        }
+        return usage;
+    }
+
+    void print() const override {
+        for (size_t i = 0; i < capacity; i++) {
+            std::cout << "[" << i << "]: ";
+            if (table[i].state == EntryState::OCCUPIED)
+                std::cout << "(" << table[i].key << "," << table[i].value << ")";
+            std::cout << "\n";
+        }
+        std::cout << "[overflow]: ";
+        for (const Entry& e : overflow)
+            std::cout << "(" << e.key << "," << e.value << ") ";
+        std::cout << "\n";
+    }
+};
+
+#endif //P3_HOPSCOTCHHASHTABLE_H
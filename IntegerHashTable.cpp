@@ -0,0 +1 @@
+#include "IntegerHashTable.h"
\ No newline at end of file
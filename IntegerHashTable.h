@@ -0,0 +1,222 @@
+#ifndef P3_INTEGERHASHTABLE_H
+#define P3_INTEGERHASHTABLE_H
+#pragma once
+
+#include "HashTable.h"
+#include "memory_policy.h"
+#include "hash_functions.h"
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// Open addressing specialised for unsigned integer keys. Empty and deleted slots are encoded as
+// sentinel key values instead of an EntryState, the hasher is a template parameter so it inlines,
+// and the capacity is a power of two so a probe step is a mask instead of a modulo.
+template<typename K, typename V, typename Hasher = IntegerMixHash>
+class IntegerHashTable : protected HashTable<K, V> {
+    static_assert(std::is_integral_v<K> && std::is_unsigned_v<K>, "IntegerHashTable needs an unsigned integer key");
+
+private:
+    static constexpr K EMPTY_KEY = std::numeric_limits<K>::max();
+    static constexpr K DELETED_KEY = std::numeric_limits<K>::max() - 1;
+
+    K* keys;
+    V* values;
+    size_t capacity;
+    size_t min_capacity;
+    size_t size;
+    size_t tombstones;
+    Hasher hasher;
+    MemoryPolicy memory_policy;
+
+    // keys that collide with the sentinels live outside the slot arrays
+    bool has_empty_key = false;
+    bool has_deleted_key = false;
+    V empty_key_value{};
+    V deleted_key_value{};
+
+    static constexpr size_t next_power_of_two(size_t n) {
+        size_t result = 8;
+        while (result < n) result <<= 1;
+        return result;
+    }
+
+    static constexpr bool is_sentinel(K key) {
+        return key == EMPTY_KEY || key == DELETED_KEY;
+    }
+
+    void allocate(size_t new_capacity) {
+        keys = allocate_slots<K>(new_capacity, memory_policy);
+        values = allocate_slots<V>(new_capacity, memory_policy);
+        for (size_t i = 0; i < new_capacity; i++)
+            keys[i] = EMPTY_KEY;
+        capacity = new_capacity;
+        tombstones = 0;
+    }
+
+    void rehash(size_t new_capacity) {
+        K* old_keys = keys;
+        V* old_values = values;
+        size_t old_capacity = capacity;
+
+        allocate(new_capacity);
+        size_t mask = capacity - 1;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (is_sentinel(old_keys[i])) continue;
+            size_t index = hasher(old_keys[i], capacity) & mask;
+            while (keys[index] != EMPTY_KEY)
+                index = (index + 1) & mask;
+            keys[index] = old_keys[i];
+            values[index] = old_values[i];
+        }
+
+        release_slots(old_keys, old_capacity, memory_policy);
+        release_slots(old_values, old_capacity, memory_policy);
+    }
+
+    void rehash_up() override {
+        rehash(capacity * 2);
+    }
+
+    void rehash_down() override {
+        if (capacity <= min_capacity) return;
+        rehash(capacity / 2 < min_capacity ? min_capacity : capacity / 2);
+    }
+
+    size_t find(K key) const {
+        size_t mask = capacity - 1;
+        size_t index = hasher(key, capacity) & mask;
+        for (size_t i = 0; i < capacity; i++) {
+            K slot = keys[index];
+            if (slot == key) return index;
+            if (slot == EMPTY_KEY) return capacity;
+            index = (index + 1) & mask;
+        }
+        return capacity;
+    }
+
+public:
+    explicit IntegerHashTable(size_t initial_capacity, MemoryPolicy policy = {})
+            : capacity(0), min_capacity(next_power_of_two(initial_capacity)), size(0), tombstones(0),
+              memory_policy(policy) {
+        allocate(min_capacity);
+    }
+
+    ~IntegerHashTable() {
+        release_slots(keys, capacity, memory_policy);
+        release_slots(values, capacity, memory_policy);
+    }
+
+    void insert(const K& key, const V& value) override {
+        if (is_sentinel(key)) {
+            bool& present = key == EMPTY_KEY ? has_empty_key : has_deleted_key;
+            if (!present) size++;
+            present = true;
+            (key == EMPTY_KEY ? empty_key_value : deleted_key_value) = value;
+            return;
+        }
+
+        if ((size + 1) * 2 > capacity)
+            rehash_up();
+        else if ((size + tombstones + 1) * 2 > capacity)
+            rehash(capacity);
+
+        size_t mask = capacity - 1;
+        size_t index = hasher(key, capacity) & mask;
+        size_t free_slot = capacity;
+        for (size_t i = 0; i < capacity; i++) {
+            K slot = keys[index];
+            if (slot == key) {
+                values[index] = value;
+                return;
+            }
+            if (slot == EMPTY_KEY) {
+                if (free_slot == capacity) free_slot = index;
+                break;
+            }
+            if (slot == DELETED_KEY && free_slot == capacity)
+                free_slot = index;
+            index = (index + 1) & mask;
+        }
+        if (free_slot == capacity)
+            throw std::overflow_error("HashTable is full");
+
+        if (keys[free_slot] == DELETED_KEY) tombstones--;
+        keys[free_slot] = key;
+        values[free_slot] = value;
+        size++;
+    }
+
+    bool remove(const K& key) override {
+        if (is_sentinel(key)) {
+            bool& present = key == EMPTY_KEY ? has_empty_key : has_deleted_key;
+            if (!present) return false;
+            present = false;
+            size--;
+            return true;
+        }
+
+        size_t index = find(key);
+        if (index == capacity) return false;
+
+        keys[index] = DELETED_KEY;
+        tombstones++;
+        size--;
+        if (size < capacity / 4 && capacity > min_capacity)
+            rehash_down();
+        return true;
+    }
+
+    // marks every slot empty and keeps the arrays
+    void clear() {
+        std::fill(keys, keys + capacity, EMPTY_KEY);
+        tombstones = 0;
+        has_empty_key = false;
+        has_deleted_key = false;
+        size = 0;
+    }
+
+    // rehashes into the smallest capacity that holds the current entries, but not below the
+    // initial one
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_power_of_two(size * 2));
+        if (fitted < capacity) rehash(fitted);
+    }
+
+    V* getValue(const K& key) const override {
+        if (is_sentinel(key)) {
+            if (key == EMPTY_KEY)
+                return has_empty_key ? const_cast<V*>(&empty_key_value) : nullptr;
+            return has_deleted_key ? const_cast<V*>(&deleted_key_value) : nullptr;
+        }
+        size_t index = find(key);
+        return index == capacity ? nullptr : &values[index];
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity;
+        usage.arrays = slot_bytes<K>(capacity, memory_policy) + slot_bytes<V>(capacity, memory_policy);
+        for (size_t i = 0; i < capacity; i++)
+            usage.value_storage += heap_bytes(values[i]);
+        usage.value_storage += heap_bytes(empty_key_value) + heap_bytes(deleted_key_value);
+        return usage;
+    }
+
+    void print() const override {
+        for (size_t i = 0; i < capacity; i++) {
+            std::cout << "[" << i << "]: ";
+            if (!is_sentinel(keys[i]))
+                std::cout << "(" << keys[i] << "," << values[i] << ")";
+            std::cout << "\n";
+        }
+        if (has_empty_key)
+            std::cout << "[empty-key]: (" << EMPTY_KEY << "," << empty_key_value << ")\n";
+        if (has_deleted_key)
+            std::cout << "[deleted-key]: (" << DELETED_KEY << "," << deleted_key_value << ")\n";
+    }
+};
+
+#endif //P3_INTEGERHASHTABLE_H
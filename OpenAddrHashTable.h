@@ -3,127 +3,517 @@
 #pragma once
 
 #include "HashTable.h"
+#include "memory_policy.h"
+#include "probe_policies.h"
+#include "hash_functions.h"
+#include "BloomFilter.h"
+#include "TimerWheel.h"
+#include "FrozenHashTable.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
 #include <stdexcept>
+#include <chrono>
+#include <span>
 
-template<typename K, typename V>
+template<typename K, typename V, typename Probe = LinearProbe>
 class OpenAddrHashTable : protected HashTable<K, V> {
 private:
     struct Entry {
         K key;
         V value;
         EntryState state = EntryState::EMPTY;
+        bool referenced = false;   // CLOCK bit, only maintained in cache mode
     };
 
     Entry* table;
     size_t capacity;
+    FastMod mod_capacity;
     size_t min_capacity;
     size_t size;
+    size_t deleted = 0;
     std::function<size_t(const K&, size_t)> hasher;
+    MemoryPolicy memory_policy;
+    Probe probe_policy;
 
-    void rehash_up() override {
-        size_t new_capacity = next_prime(capacity * 2);
+    // optional batch form of hasher used by insert_many/get_many, e.g. hash_many for DJB2Hash
+    std::function<void(std::span<const K>, std::span<size_t>)> batch_hasher;
+    static constexpr size_t BATCH = 32;
+
+    // keyed hashing: when set, `hasher` forwards to it with the table's current seed
+    std::function<size_t(const K&, size_t, const HashSeed&)> seeded_hasher;
+    HashSeed seed;
+    ReseedTrigger reseed_trigger;
+    size_t reseed_count = 0;
+    bool rehashing = false;   // rehash() re-inserts through insert_hashed, which must not reseed
+
+    // optional front filter over hasher output; removed keys leave stale bits until the next rebuild
+    std::unique_ptr<BlockedBloomFilter> filter;
+    size_t filter_stale = 0;
+
+    // cache mode: CLOCK eviction once the limits are exceeded
+    CacheLimits<K, V> cache_limits;
+    size_t cache_bytes = 0;
+    size_t clock_hand = 0;
+    mutable CacheStats stats;
+
+    size_t charge(const K& key, const V& value) const {
+        return cache_limits.entry_bytes ? cache_limits.entry_bytes(key, value) : 0;
+    }
+
+    bool over_limits() const {
+        return (cache_limits.max_entries != 0 && size > cache_limits.max_entries) ||
+               (cache_limits.max_bytes != 0 && cache_bytes > cache_limits.max_bytes);
+    }
+
+    void evict_one() {
+        while (true) {
+            size_t index = clock_hand;
+            clock_hand = clock_hand + 1 == capacity ? 0 : clock_hand + 1;
+            if (table[index].state != EntryState::OCCUPIED) continue;
+            if (table[index].referenced) {
+                table[index].referenced = false;
+                continue;
+            }
+            erase_slot(index);
+            stats.evictions++;
+            if (filter && filter_stale > size)
+                rebuild_filter();
+            return;
+        }
+    }
+
+    // expiry mode: absolute steady_clock deadlines in ns per slot (0 = none), plus a timer wheel
+    // that lets expire() find due entries without scanning the table
+    uint64_t* expiry = nullptr;
+    std::unique_ptr<TimerWheel<K>> wheel;
+    // set by expire(), which leaves the O(n) shrink or filter rebuild its removals call for to
+    // the next insert so that a tick costs no more than its removals
+    bool resize_pending = false;
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool is_expired(size_t index) const {
+        return expiry && expiry[index] != 0 && expiry[index] <= now_ns();
+    }
+
+    void erase_slot(size_t index) {
+        table[index].state = EntryState::DELETED;
+        deleted++;
+        size--;
+        if (cache_limits.enabled())
+            cache_bytes -= charge(table[index].key, table[index].value);
+        if (filter) filter_stale++;
+    }
+
+    void rebuild_filter() {
+        filter->reset(capacity / 2);
+        filter_stale = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            if (table[i].state == EntryState::OCCUPIED)
+                filter->add(hasher(table[i].key, capacity));
+        }
+    }
+
+    void rehash(size_t new_capacity) {
         Entry* old_table = table;
+        uint64_t* old_expiry = expiry;
         size_t old_capacity = capacity;
 
-        table = new Entry[new_capacity];
+        table = allocate_slots<Entry>(new_capacity, memory_policy);
+        if (old_expiry) {
+            expiry = allocate_slots<uint64_t>(new_capacity, memory_policy);
+            std::fill(expiry, expiry + new_capacity, 0);
+        }
         capacity = new_capacity;
+        mod_capacity = FastMod(capacity);
         size = 0;
+        deleted = 0;
+        cache_bytes = 0;
+        clock_hand = 0;
+        if (filter) {
+            filter->reset(capacity / 2);
+            filter_stale = 0;
+        }
 
+        rehashing = true;
         for (size_t i = 0; i < old_capacity; i++) {
             if (old_table[i].state == EntryState::OCCUPIED) {
-                insert(old_table[i].key, old_table[i].value);
+                insert_entry(old_table[i].key, old_table[i].value, old_expiry ? old_expiry[i] : 0);
             }
         }
+        rehashing = false;
 
-        delete[] old_table;
+        release_slots(old_table, old_capacity, memory_policy);
+        if (old_expiry)
+            release_slots(old_expiry, old_capacity, memory_policy);
+    }
+
+    void rehash_up() override {
+        rehash(next_table_prime(capacity * 2));
     }
 
     void rehash_down() override {
         if (capacity <= min_capacity) return;
 
-        size_t new_capacity = previous_prime(capacity / 2);
+        size_t new_capacity = previous_table_prime(capacity / 2);
         if (new_capacity < min_capacity) {
             new_capacity = min_capacity;
         }
+        rehash(new_capacity);
+    }
 
-        Entry* old_table = table;
-        size_t old_capacity = capacity;
+    // expired entries count as absent unless include_expired is set
+    size_t find(const K& key, bool include_expired = false) const {
+        return find_hashed(key, hasher(key, capacity), include_expired);
+    }
 
-        table = new Entry[new_capacity];
-        capacity = new_capacity;
-        size = 0;
+    size_t find_hashed(const K& key, size_t hash, bool include_expired = false) const {
+        if (filter && !filter->may_contain(hash)) return capacity;
 
-        for (size_t i = 0; i < old_capacity; i++) {
-            if (old_table[i].state == EntryState::OCCUPIED) {
-                insert(old_table[i].key, old_table[i].value);
-            }
+        size_t index = mod_capacity(hash);
+        size_t step = probe_policy.step(key, capacity);
+        for (size_t i = 1; i <= capacity; i++) {
+            if (table[index].state == EntryState::EMPTY) return capacity;
+            if (table[index].state == EntryState::OCCUPIED && table[index].key == key)
+                return include_expired || !is_expired(index) ? index : capacity;
+            index = probe_policy.next(index, i, step, capacity);
         }
-
-        delete[] old_table;
+        return capacity;
     }
 
-    size_t probe(const K& key, size_t i) const {
-        return (hasher(key, capacity) + i) % capacity;
+public:
+    explicit OpenAddrHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc,
+                               MemoryPolicy policy = {}, Probe probe = {})
+            : capacity(next_prime(initial_capacity)), size(0), min_capacity(next_prime(initial_capacity)),
+              hasher(std::move(hashFunc)), memory_policy(policy), probe_policy(std::move(probe)) {
+        mod_capacity = FastMod(capacity);
+        table = allocate_slots<Entry>(capacity, memory_policy);
     }
 
-public:
-    explicit OpenAddrHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc)
+    // keyed hashing for untrusted keys: the table draws a random seed and, if reseed_after is
+    // non-zero, draws a new one and rehashes when an insert needs more probes than that plus
+    // log2 of the size, at most once per `size` inserts (see ReseedTrigger)
+    explicit OpenAddrHashTable(size_t initial_capacity,
+                               std::function<size_t(const K&, size_t, const HashSeed&)> seededHashFunc,
+                               size_t reseed_after = 0, MemoryPolicy policy = {}, Probe probe = {})
             : capacity(next_prime(initial_capacity)), size(0), min_capacity(next_prime(initial_capacity)),
-              hasher(std::move(hashFunc)) {
-        table = new Entry[capacity];
+              memory_policy(policy), probe_policy(std::move(probe)), seeded_hasher(std::move(seededHashFunc)),
+              seed(HashSeed::random()), reseed_trigger{ reseed_after } {
+        hasher = [this](const K& key, size_t cap) { return seeded_hasher(key, cap, seed); };
+        mod_capacity = FastMod(capacity);
+        table = allocate_slots<Entry>(capacity, memory_policy);
     }
 
     ~OpenAddrHashTable() {
-        delete[] table;
+        release_slots(table, capacity, memory_policy);
+        if (expiry)
+            release_slots(expiry, capacity, memory_policy);
     }
 
     void insert(const K& key, const V& value) override {
+        insert_entry(key, value, 0);
+    }
+
+    // inserts with a time to live; the entry reads as absent once it has passed and is physically
+    // removed by expire(), by remove() or when its slot is reused. Until then it still occupies its
+    // slot and counts towards the load factor
+    void insert(const K& key, const V& value, std::chrono::nanoseconds ttl) {
+        if (!expiry) enable_expiry();
+        uint64_t deadline = now_ns() + ttl.count();
+        insert_entry(key, value, deadline);
+        wheel->schedule(key, deadline);
+    }
+
+    void enable_expiry(std::chrono::nanoseconds tick = std::chrono::milliseconds(100), size_t wheel_slots = 512) {
+        if (!expiry) {
+            expiry = allocate_slots<uint64_t>(capacity, memory_policy);
+            std::fill(expiry, expiry + capacity, 0);
+        }
+        wheel = std::make_unique<TimerWheel<K>>(tick.count(), wheel_slots, now_ns());
+    }
+
+    // removes at most max_removals due entries found through the timer wheel; shrinking is
+    // deferred to the next insert
+    size_t expire(size_t max_removals) {
+        if (!wheel) return 0;
+
+        size_t removed = 0;
+        wheel->advance(now_ns(), max_removals, [&](const K& key, uint64_t deadline) {
+            size_t index = find(key, true);
+            // the key was removed, re-inserted or given a new deadline since this timer was set
+            if (index == capacity || expiry[index] != deadline) return;
+            erase_slot(index);
+            removed++;
+        });
+        if (removed > 0) resize_pending = true;
+        return removed;
+    }
+
+    // inserts keys[i] -> values[i] for every i; room for all of them is made up front and the
+    // keys are hashed a batch at a time by the batch hasher when one is set
+    void insert_many(std::span<const K> keys, std::span<const V> values) {
+        if (keys.size() != values.size())
+            throw std::invalid_argument("insert_many: keys and values differ in length");
+        if ((size + keys.size()) * 2 > capacity)
+            rehash(next_prime((size + keys.size()) * 2));
+        if (!batch_hasher || seeded_hasher) {
+            for (size_t i = 0; i < keys.size(); i++)
+                insert_entry(keys[i], values[i], 0);
+            return;
+        }
+        size_t hashes[BATCH];
+        for (size_t start = 0; start < keys.size(); start += BATCH) {
+            size_t n = std::min(BATCH, keys.size() - start);
+            batch_hasher(keys.subspan(start, n), std::span<size_t>(hashes, n));
+            for (size_t i = 0; i < n; i++) {
+                make_room();
+                insert_hashed(keys[start + i], hashes[i], values[start + i], 0);
+            }
+        }
+    }
+
+    // `batch` must compute exactly what the table's hasher does, for any capacity; it is not
+    // used by tables with keyed hashing
+    void set_batch_hasher(std::function<void(std::span<const K>, std::span<size_t>)> batch) {
+        batch_hasher = std::move(batch);
+    }
+
+private:
+    void make_room() {
+        if (resize_pending) {
+            resize_pending = false;
+            if (size < capacity / 4 && capacity > min_capacity) {
+                rehash_down();
+            } else if (filter && filter_stale > size) {
+                rebuild_filter();
+            }
+        }
         if ((size + 1) * 2 > capacity) {
             rehash_up();
+        } else if ((size + deleted + 1) * 4 > capacity * 3) {
+            // tombstones left by removals would otherwise eat every EMPTY slot that ends a probe
+            rehash(capacity);
         }
-        for (size_t i = 0; i < capacity; i++) {
-            size_t index = probe(key, i);
-            if (table[index].state == EntryState::EMPTY || table[index].state == EntryState::DELETED) {
-                table[index] = { key, value, EntryState::OCCUPIED };
-                size++;
-                return;
-            } else if (table[index].state == EntryState::OCCUPIED && table[index].key == key) {
+    }
+
+    void insert_entry(const K& key, const V& value, uint64_t expires_at) {
+        make_room();
+        insert_hashed(key, hasher(key, capacity), value, expires_at);
+    }
+
+    void insert_hashed(const K& key, size_t hash, const V& value, uint64_t expires_at) {
+        size_t index = mod_capacity(hash);
+        size_t step = probe_policy.step(key, capacity);
+        size_t free_slot = capacity;
+        size_t probes = 0;
+        // a DELETED slot is only reused once the key is known to be absent further along
+        for (size_t i = 1; i <= capacity; i++) {
+            if (table[index].state == EntryState::EMPTY) {
+                if (free_slot == capacity) {
+                    free_slot = index;
+                    probes = i;
+                }
+                break;
+            } else if (table[index].state == EntryState::DELETED) {
+                if (free_slot == capacity) {
+                    free_slot = index;
+                    probes = i;
+                }
+            } else if (table[index].key == key) {
+                if (cache_limits.enabled()) {
+                    cache_bytes += charge(key, value) - charge(key, table[index].value);
+                    table[index].referenced = true;
+                }
                 table[index].value = value;
+                if (expiry) expiry[index] = expires_at;
+                // a larger value can push the cache over its byte budget just like a new entry
+                while (cache_limits.enabled() && size > 1 && over_limits())
+                    evict_one();
                 return;
             }
+            index = probe_policy.next(index, i, step, capacity);
         }
-        throw std::overflow_error("HashTable is full");
+        if (free_slot == capacity)
+            throw std::overflow_error("HashTable is full");
+
+        if (table[free_slot].state == EntryState::DELETED) deleted--;
+        table[free_slot] = { key, value, EntryState::OCCUPIED };
+        if (expiry) expiry[free_slot] = expires_at;
+        size++;
+        if (filter) filter->add(hash);
+
+        if (cache_limits.enabled()) {
+            table[free_slot].referenced = true;
+            cache_bytes += charge(key, value);
+            while (size > 1 && over_limits())
+                evict_one();
+        }
+
+        if (!rehashing && reseed_trigger.due(probes, size))
+            reseed();
     }
 
+public:
+
+    void reseed() {
+        if (!seeded_hasher) return;
+        seed = HashSeed::random();
+        rehash(capacity);
+        reseed_trigger.reset();
+        reseed_count++;
+    }
+
+    // seeds drawn since construction, by reseed() calls and automatic reseeds alike
+    size_t reseeds() const {
+        return reseed_count;
+    }
+
+    // an expired entry the timer wheel has not swept yet is erased too, but reported as absent
     bool remove(const K& key) override {
+        size_t index = find(key, true);
+        if (index == capacity) return false;
+
+        bool live = !is_expired(index);
+        erase_slot(index);
+        if (size < capacity / 4 && capacity > min_capacity) {
+            rehash_down();
+        } else if (filter && filter_stale > size) {
+            rebuild_filter();
+        }
+        return live;
+    }
+
+    // empties the table in one pass over the slot states, keeping its capacity and slot array so
+    // a table reused per request allocates nothing; keys and values left in the slots keep their
+    // buffers, which the next entries assigned there reuse
+    void clear() {
         for (size_t i = 0; i < capacity; i++) {
-            size_t index = probe(key, i);
-            if (table[index].state == EntryState::EMPTY) {
-                return false;
-            } else if (table[index].state == EntryState::OCCUPIED && table[index].key == key) {
-                table[index].state = EntryState::DELETED;
-                size--;
-                if (size < capacity / 4 && capacity > min_capacity)
-                    rehash_down();
-                return true;
-            }
+            table[i].state = EntryState::EMPTY;
+            table[i].referenced = false;
         }
-        return false;
+        if (expiry) std::fill(expiry, expiry + capacity, 0);
+        if (wheel) wheel->clear();
+        if (filter) {
+            filter->reset(capacity / 2);
+            filter_stale = 0;
+        }
+        size = 0;
+        deleted = 0;
+        cache_bytes = 0;
+        clock_hand = 0;
+        resize_pending = false;
     }
 
-    V* getValue(const K& key) const override {
+    // rehashes into the smallest capacity that holds the current entries, but not below the
+    // initial one, freeing the old slots and whatever buffers they still held
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_prime(size * 2));
+        if (fitted < capacity) rehash(fitted);
+    }
+
+    // consults a blocked Bloom filter before probing, so most lookups of absent keys cost one
+    // cache line instead of a probe sequence ending at an EMPTY slot
+    void enable_filter(size_t bits_per_key = 10) {
+        filter = std::make_unique<BlockedBloomFilter>(capacity / 2, bits_per_key);
+        rebuild_filter();
+    }
+
+    // bounds the table to `limits`; inserting past them evicts entries not used since the clock
+    // hand last passed them. Returns to unbounded mode with default limits.
+    void set_cache_limits(CacheLimits<K, V> limits) {
+        cache_limits = std::move(limits);
+        cache_bytes = 0;
         for (size_t i = 0; i < capacity; i++) {
-            size_t index = probe(key, i);
-            if (table[index].state == EntryState::EMPTY) return nullptr;
-            if (table[index].state == EntryState::OCCUPIED && table[index].key == key)
-                return &table[index].value;
+            if (table[i].state == EntryState::OCCUPIED)
+                cache_bytes += charge(table[i].key, table[i].value);
+        }
+        while (size > 0 && over_limits())
+            evict_one();
+    }
+
+    CacheStats cache_stats() const {
+        return stats;
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity;
+        usage.arrays = slot_bytes<Entry>(capacity, memory_policy);
+        if (expiry) usage.arrays += slot_bytes<uint64_t>(capacity, memory_policy);
+        // DELETED and EMPTY slots may still hold the buffers of keys removed from them
+        for (size_t i = 0; i < capacity; i++) {
+            usage.key_storage += heap_bytes(table[i].key);
+            usage.value_storage += heap_bytes(table[i].value);
+        }
+        if (filter) usage.other += filter->memory_bytes();
+        if (wheel) usage.other += wheel->memory_bytes();
+        return usage;
+    }
+
+    // copies the live entries into a compact read-only FrozenHashTable; this table is left as is
+    // and can be dropped once the frozen copy has been built
+    FrozenHashTable<K, V> freeze() const {
+        std::function<size_t(const K&, size_t)> frozen_hasher = hasher;
+        if (seeded_hasher) {
+            frozen_hasher = [f = seeded_hasher, s = seed](const K& key, size_t cap) { return f(key, cap, s); };
+        }
+        uint64_t now = now_ns();
+        return FrozenHashTable<K, V>(size, std::move(frozen_hasher), [&](auto&& emit) {
+            for (size_t i = 0; i < capacity; i++) {
+                bool expired = expiry && expiry[i] != 0 && expiry[i] <= now;
+                if (table[i].state == EntryState::OCCUPIED && !expired)
+                    emit(table[i].key, table[i].value);
+            }
+        });
+    }
+
+    V* getValue(const K& key) const override {
+        return found(find(key));
+    }
+
+    // looks up keys[i] into values[i] for every i, with the keys hashed a batch at a time by the
+    // batch hasher and every home slot of a batch prefetched before the first one is probed
+    void get_many(std::span<const K> keys, std::span<V*> values) const {
+        if (keys.size() != values.size())
+            throw std::invalid_argument("get_many: keys and values differ in length");
+        if (!batch_hasher || seeded_hasher) {
+            for (size_t i = 0; i < keys.size(); i++)
+                values[i] = getValue(keys[i]);
+            return;
+        }
+        size_t hashes[BATCH];
+        for (size_t start = 0; start < keys.size(); start += BATCH) {
+            size_t n = std::min(BATCH, keys.size() - start);
+            batch_hasher(keys.subspan(start, n), std::span<size_t>(hashes, n));
+            for (size_t i = 0; i < n; i++)
+                __builtin_prefetch(&table[mod_capacity(hashes[i])]);
+            for (size_t i = 0; i < n; i++)
+                values[start + i] = found(find_hashed(keys[start + i], hashes[i]));
         }
-        return nullptr;
     }
 
+private:
+    // the value at a find() result, counting the hit or miss in cache mode
+    V* found(size_t index) const {
+        if (cache_limits.enabled()) {
+            if (index == capacity) {
+                stats.misses++;
+            } else {
+                stats.hits++;
+                table[index].referenced = true;
+            }
+        }
+        return index == capacity ? nullptr : &table[index].value;
+    }
+
+public:
+
     void print() const override {
         for (size_t i = 0; i < capacity; i++) {
             std::cout << "[" << i << "]: ";
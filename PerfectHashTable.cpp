@@ -0,0 +1 @@
+#include "PerfectHashTable.h"
\ No newline at end of file
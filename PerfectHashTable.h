@@ -0,0 +1,239 @@
+#ifndef P3_PERFECTHASHTABLE_H
+#define P3_PERFECTHASHTABLE_H
+#pragma once
+
+#include "hash_functions.h"
+#include "memory_policy.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal perfect hashing in the CHD/PTHash style: keys are split into small buckets by their
+// hash, and every bucket gets a pilot chosen so that its keys land on slots nobody else uses.
+// A lookup is hash -> bucket -> pilot -> slot, one key comparison, no probing and no empty
+// slots. Buckets are placed largest first, while the table still has room for them.
+
+// the slot of a key with hash h under a bucket's pilot
+constexpr size_t perfect_slot(uint64_t h, uint64_t pilot, size_t slots) {
+    return IntegerMixHash()(h ^ (pilot * 0x9e3779b97f4a7c15ULL)) % slots;
+}
+
+// average number of keys per bucket; larger buckets mean fewer pilots but a slower build
+constexpr size_t PERFECT_BUCKET_SIZE = 4;
+
+// capacity passed to the seed hasher; hashers that scale into [0, capacity) such as FibonacciHash
+// need a range far wider than the key count to give distinct keys distinct seeds
+constexpr size_t PERFECT_HASH_RANGE = size_t(1) << 32;
+
+// Read-only table built at startup from a fixed key set. The hasher is called with capacity
+// PERFECT_HASH_RANGE and its output remixed into the seed for every pilot, so keys whose hashes
+// collide cannot be separated and are rejected at build time. DJB2Hash and CRC32CHash suit any
+// key set; AdditiveHash and MultiplicativeHash give anagrams the same hash, and FibonacciHash
+// gives every key longer than ten characters hash 0, so those fail on most sets.
+template<typename K, typename V>
+class PerfectHashTable {
+private:
+    std::vector<K> keys;
+    std::vector<V> values;
+    std::vector<uint32_t> pilots;
+    std::function<size_t(const K&, size_t)> hasher;
+
+    uint64_t hash(const K& key) const {
+        return IntegerMixHash()(hasher(key, PERFECT_HASH_RANGE));
+    }
+
+    size_t slot(const K& key) const {
+        uint64_t h = hash(key);
+        return perfect_slot(h, pilots[h % pilots.size()], keys.size());
+    }
+
+public:
+    // duplicate keys keep the last value, like repeated inserts
+    PerfectHashTable(const std::vector<std::pair<K, V>>& entries, std::function<size_t(const K&, size_t)> hashFunc)
+            : hasher(std::move(hashFunc)) {
+        struct Item {
+            uint64_t hash;
+            size_t bucket;
+            size_t entry;
+        };
+
+        size_t n = entries.size();
+        pilots.assign(n / PERFECT_BUCKET_SIZE + 1, 0);
+
+        std::vector<Item> items(n);
+        for (size_t i = 0; i < n; i++) {
+            uint64_t h = hash(entries[i].first);
+            items[i] = { h, h % pilots.size(), i };
+        }
+        std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+            return a.bucket != b.bucket ? a.bucket < b.bucket : a.hash < b.hash;
+        });
+
+        std::vector<Item> unique;
+        for (const Item& item : items) {
+            if (!unique.empty() && unique.back().hash == item.hash) {
+                if (!(entries[unique.back().entry].first == entries[item.entry].first))
+                    throw std::invalid_argument("PerfectHashTable: two keys have the same hash, use a stronger hasher");
+                unique.back().entry = item.entry;
+                continue;
+            }
+            unique.push_back(item);
+        }
+        n = unique.size();
+        keys.resize(n);
+        values.resize(n);
+        if (n == 0) return;
+
+        // [begin, end) ranges of each bucket within `unique`, visited from largest to smallest
+        std::vector<std::pair<size_t, size_t>> buckets;
+        for (size_t begin = 0; begin < n;) {
+            size_t end = begin + 1;
+            while (end < n && unique[end].bucket == unique[begin].bucket) end++;
+            buckets.push_back({ begin, end });
+            begin = end;
+        }
+        std::stable_sort(buckets.begin(), buckets.end(), [](const auto& a, const auto& b) {
+            return a.second - a.first > b.second - b.first;
+        });
+
+        std::vector<bool> taken(n, false);
+        std::vector<size_t> placed;
+        for (const auto& [begin, end] : buckets) {
+            uint64_t pilot = 0;
+            while (true) {
+                placed.clear();
+                for (size_t i = begin; i < end; i++) {
+                    size_t s = perfect_slot(unique[i].hash, pilot, n);
+                    if (taken[s] || std::find(placed.begin(), placed.end(), s) != placed.end()) break;
+                    placed.push_back(s);
+                }
+                if (placed.size() == end - begin) break;
+                if (++pilot > std::numeric_limits<uint32_t>::max())
+                    throw std::overflow_error("PerfectHashTable: no pilot found for a bucket");
+            }
+
+            pilots[unique[begin].bucket] = static_cast<uint32_t>(pilot);
+            for (size_t i = begin; i < end; i++) {
+                size_t s = placed[i - begin];
+                taken[s] = true;
+                keys[s] = entries[unique[i].entry].first;
+                values[s] = entries[unique[i].entry].second;
+            }
+        }
+    }
+
+    const V* getValue(const K& key) const {
+        if (keys.empty()) return nullptr;
+        size_t s = slot(key);
+        return keys[s] == key ? &values[s] : nullptr;
+    }
+
+    size_t count() const {
+        return keys.size();
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = keys.size();
+        usage.slots = keys.size();
+        usage.arrays = keys.capacity() * sizeof(K) + values.capacity() * sizeof(V) + pilots.capacity() * sizeof(uint32_t);
+        for (size_t i = 0; i < keys.size(); i++) {
+            usage.key_storage += heap_bytes(keys[i]);
+            usage.value_storage += heap_bytes(values[i]);
+        }
+        return usage;
+    }
+
+    void print() const {
+        for (size_t i = 0; i < keys.size(); i++)
+            std::cout << "[" << i << "]: (" << keys[i] << "," << values[i] << ")\n";
+    }
+};
+
+// Compile-time counterpart for string keys known at build time, hashed with djb2. The whole
+// build runs in a constant expression, so a key set that cannot be placed is a compile error.
+template<typename V, size_t N>
+class StaticPerfectHashMap {
+private:
+    static constexpr size_t NUM_BUCKETS = N / PERFECT_BUCKET_SIZE + 1;
+    static constexpr uint32_t MAX_PILOT = 1u << 20;
+
+    std::string_view keys[N] = {};
+    V values[N] = {};
+    uint32_t pilots[NUM_BUCKETS] = {};
+
+    static constexpr uint64_t hash(std::string_view key) {
+        return IntegerMixHash()(djb2(key));
+    }
+
+public:
+    constexpr StaticPerfectHashMap(const std::pair<std::string_view, V> (&entries)[N]) {
+        uint64_t hashes[N] = {};
+        size_t bucket_size[NUM_BUCKETS] = {};
+        size_t largest = 0;
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = hash(entries[i].first);
+            for (size_t j = 0; j < i; j++) {
+                if (hashes[j] == hashes[i])
+                    throw std::invalid_argument("StaticPerfectHashMap: duplicate or colliding keys");
+            }
+            largest = std::max(largest, ++bucket_size[hashes[i] % NUM_BUCKETS]);
+        }
+
+        bool taken[N] = {};
+        size_t placed[N] = {};
+        for (size_t want = largest; want > 0; want--) {
+            for (size_t b = 0; b < NUM_BUCKETS; b++) {
+                if (bucket_size[b] != want) continue;
+                for (uint32_t pilot = 0;; pilot++) {
+                    if (pilot == MAX_PILOT)
+                        throw std::overflow_error("StaticPerfectHashMap: no pilot found for a bucket");
+                    size_t count = 0;
+                    for (size_t i = 0; i < N && count < want; i++) {
+                        if (hashes[i] % NUM_BUCKETS != b) continue;
+                        size_t s = perfect_slot(hashes[i], pilot, N);
+                        bool clash = taken[s];
+                        for (size_t j = 0; j < count && !clash; j++)
+                            clash = placed[j] == s;
+                        if (clash) break;
+                        placed[count++] = s;
+                    }
+                    if (count < want) continue;
+
+                    pilots[b] = pilot;
+                    count = 0;
+                    for (size_t i = 0; i < N; i++) {
+                        if (hashes[i] % NUM_BUCKETS != b) continue;
+                        size_t s = placed[count++];
+                        taken[s] = true;
+                        keys[s] = entries[i].first;
+                        values[s] = entries[i].second;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr const V* find(std::string_view key) const {
+        uint64_t h = hash(key);
+        size_t s = perfect_slot(h, pilots[h % NUM_BUCKETS], N);
+        return keys[s] == key ? &values[s] : nullptr;
+    }
+
+    constexpr bool contains(std::string_view key) const {
+        return find(key) != nullptr;
+    }
+
+    static constexpr size_t size() {
+        return N;
+    }
+};
+
+#endif //P3_PERFECTHASHTABLE_H
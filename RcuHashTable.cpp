@@ -0,0 +1 @@
+#include "RcuHashTable.h"
\ No newline at end of file
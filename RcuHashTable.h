@@ -0,0 +1,122 @@
+#ifndef P3_RCUHASHTABLE_H
+#define P3_RCUHASHTABLE_H
+#pragma once
+
+#include "OpenAddrHashTable.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+// Read-copy-update wrapper around OpenAddrHashTable for tables that are rebuilt rarely and read
+// constantly. Writers fill a fresh table off to the side and publish it with one pointer swap.
+// Readers register once and then only load the current pointer and store their epoch to their
+// own cache line, with no lock and no read-modify-write. A replaced table is deleted once every
+// reader that might still see it has left its read-side section (the grace period).
+template<typename K, typename V>
+class RcuHashTable {
+private:
+    using Table = OpenAddrHashTable<K, V>;
+    static constexpr size_t MAX_READERS = 64;
+    static constexpr uint64_t QUIESCENT = 0;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{ QUIESCENT };
+        std::atomic<bool> in_use{ false };
+    };
+
+    std::atomic<Table*> current;
+    std::atomic<uint64_t> global_epoch{ 1 };
+    ReaderSlot readers[MAX_READERS];
+    std::mutex writer_lock;
+    size_t initial_capacity;
+    std::function<size_t(const K&, size_t)> hasher;
+
+    void wait_for_readers(uint64_t epoch) const {
+        for (const ReaderSlot& slot : readers) {
+            while (true) {
+                uint64_t seen = slot.epoch.load();
+                if (seen == QUIESCENT || seen >= epoch) break;
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    // handle owned by one reader thread
+    class Reader {
+    private:
+        RcuHashTable* rcu;
+        ReaderSlot* slot;
+
+        friend class RcuHashTable;
+        Reader(RcuHashTable* owner, ReaderSlot* s) : rcu(owner), slot(s) {}
+
+    public:
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        Reader(Reader&& other) noexcept : rcu(other.rcu), slot(other.slot) { other.slot = nullptr; }
+
+        ~Reader() {
+            if (slot) slot->in_use.store(false);
+        }
+
+        // calls f(const V&) inside the read-side section; the reference is only valid within f
+        template<typename F>
+        bool read(const K& key, F&& f) const {
+            slot->epoch.store(rcu->global_epoch.load(std::memory_order_acquire));
+            const Table* table = rcu->current.load();
+            const V* value = table->getValue(key);
+            if (value) f(*value);
+            slot->epoch.store(QUIESCENT, std::memory_order_release);
+            return value != nullptr;
+        }
+
+        std::optional<V> getValue(const K& key) const {
+            std::optional<V> result;
+            read(key, [&](const V& value) { result = value; });
+            return result;
+        }
+    };
+
+    explicit RcuHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc)
+            : current(new Table(initial_capacity, hashFunc)),
+              initial_capacity(initial_capacity), hasher(std::move(hashFunc)) {}
+
+    RcuHashTable(const RcuHashTable&) = delete;
+    RcuHashTable& operator=(const RcuHashTable&) = delete;
+
+    ~RcuHashTable() {
+        delete current.load();
+    }
+
+    Reader register_reader() {
+        for (ReaderSlot& slot : readers) {
+            bool expected = false;
+            if (slot.in_use.compare_exchange_strong(expected, true))
+                return Reader(this, &slot);
+        }
+        throw std::overflow_error("RcuHashTable has no free reader slots");
+    }
+
+    // publishes `next` and blocks until no reader can still observe the previous table
+    void publish(std::unique_ptr<Table> next) {
+        std::lock_guard<std::mutex> guard(writer_lock);
+        Table* old = current.exchange(next.release());
+        uint64_t epoch = global_epoch.fetch_add(1) + 1;
+        wait_for_readers(epoch);
+        delete old;
+    }
+
+    // builds a new version with `fill` and publishes it
+    void rebuild(const std::function<void(Table&)>& fill) {
+        auto next = std::make_unique<Table>(initial_capacity, hasher);
+        fill(*next);
+        publish(std::move(next));
+    }
+};
+
+#endif //P3_RCUHASHTABLE_H
@@ -0,0 +1 @@
+#include "SplitOpenAddrHashTable.h"
\ No newline at end of file
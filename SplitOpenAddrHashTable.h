@@ -0,0 +1,241 @@
+#ifndef P3_SPLITOPENADDRHASHTABLE_H
+#define P3_SPLITOPENADDRHASHTABLE_H
+#pragma once
+
+#include "HashTable.h"
+#include "control_group.h"
+#include "cpu_dispatch.h"
+#include "memory_policy.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <stdexcept>
+
+// Open addressing with a struct-of-arrays layout: probing scans the dense control bytes
+// and only touches keys on a fingerprint match and values on a hit. The scan compares a
+// whole group of control bytes per step, 16, 32 or 64 wide depending on cpu_level().
+template<typename K, typename V>
+class SplitOpenAddrHashTable : protected HashTable<K, V> {
+private:
+    static constexpr uint8_t CTRL_EMPTY = 0x00;
+    static constexpr uint8_t CTRL_DELETED = 0x01;
+    static constexpr uint8_t CTRL_OCCUPIED = 0x80;
+
+    uint8_t* control;
+    K* keys;
+    V* values;
+    size_t capacity;
+    size_t min_capacity;
+    size_t size;
+    std::function<size_t(const K&, size_t)> hasher;
+    MemoryPolicy memory_policy;
+
+    static uint8_t fingerprint(size_t hash) {
+        return CTRL_OCCUPIED | static_cast<uint8_t>((hash ^ (hash >> 7)) & 0x7F);
+    }
+
+    void allocate(size_t new_capacity) {
+        control = allocate_slots<uint8_t>(new_capacity, memory_policy);
+        keys = allocate_slots<K>(new_capacity, memory_policy);
+        values = allocate_slots<V>(new_capacity, memory_policy);
+        for (size_t i = 0; i < new_capacity; i++)
+            control[i] = CTRL_EMPTY;
+        capacity = new_capacity;
+    }
+
+    void release(uint8_t* old_control, K* old_keys, V* old_values, size_t old_capacity) {
+        release_slots(old_control, old_capacity, memory_policy);
+        release_slots(old_keys, old_capacity, memory_policy);
+        release_slots(old_values, old_capacity, memory_policy);
+    }
+
+    void rehash(size_t new_capacity) {
+        uint8_t* old_control = control;
+        K* old_keys = keys;
+        V* old_values = values;
+        size_t old_capacity = capacity;
+
+        allocate(new_capacity);
+        size = 0;
+
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_control[i] & CTRL_OCCUPIED) {
+                insert(old_keys[i], old_values[i]);
+            }
+        }
+
+        release(old_control, old_keys, old_values, old_capacity);
+    }
+
+    void rehash_up() override {
+        rehash(next_table_prime(capacity * 2));
+    }
+
+    void rehash_down() override {
+        if (capacity <= min_capacity) return;
+
+        size_t new_capacity = previous_table_prime(capacity / 2);
+        if (new_capacity < min_capacity) {
+            new_capacity = min_capacity;
+        }
+        rehash(new_capacity);
+    }
+
+    // walks the linear probe sequence of hash a group of control bytes at a time and returns the
+    // slot holding key, or capacity; *free_slot, if given, gets the first free slot on the way
+    template<typename Group>
+    size_t probe_groups(const K& key, size_t hash, size_t* free_slot) const {
+        uint8_t tag = fingerprint(hash);
+        size_t index = hash % capacity;
+        for (size_t probed = 0; probed < capacity;) {
+            // a group that would run past the end of the array is taken a byte at a time
+            bool whole = index + Group::WIDTH <= capacity;
+            ControlMask mask = whole ? Group::match(control + index, tag)
+                                     : ScalarControlGroup::match(control + index, tag);
+            // slots after the first EMPTY are not on the sequence
+            uint64_t reached = mask.empty ? mask.empty ^ (mask.empty - 1) : ~0ULL;
+            for (uint64_t match = mask.tag & reached; match; match &= match - 1) {
+                size_t slot = index + __builtin_ctzll(match);
+                if (keys[slot] == key) return slot;
+            }
+            if (free_slot && *free_slot == capacity && (mask.free & reached))
+                *free_slot = index + __builtin_ctzll(mask.free & reached);
+            if (mask.empty) return capacity;
+
+            size_t width = whole ? Group::WIDTH : 1;
+            probed += width;
+            index += width;
+            if (index == capacity) index = 0;
+        }
+        return capacity;
+    }
+
+#if defined(__x86_64__)
+    // flatten pulls the group matcher into the loop, which plain inlining will not do across
+    // differing targets
+    __attribute__((target("sse4.2"), flatten))
+    size_t probe_sse42(const K& key, size_t hash, size_t* free_slot) const {
+        return probe_groups<Sse42ControlGroup>(key, hash, free_slot);
+    }
+
+    __attribute__((target("avx2"), flatten))
+    size_t probe_avx2(const K& key, size_t hash, size_t* free_slot) const {
+        return probe_groups<Avx2ControlGroup>(key, hash, free_slot);
+    }
+
+    __attribute__((target("avx512f,avx512bw"), flatten))
+    size_t probe_avx512(const K& key, size_t hash, size_t* free_slot) const {
+        return probe_groups<Avx512ControlGroup>(key, hash, free_slot);
+    }
+#endif
+
+    size_t probe(const K& key, size_t hash, size_t* free_slot = nullptr) const {
+        // most probes end at the home slot, which is cheaper to test on its own than as a group
+        size_t home = hash % capacity;
+        if (control[home] == fingerprint(hash) && keys[home] == key) return home;
+        if (control[home] == CTRL_EMPTY) {
+            if (free_slot) *free_slot = home;
+            return capacity;
+        }
+        switch (cpu_level()) {
+#if defined(__x86_64__)
+            case CpuLevel::AVX512: return probe_avx512(key, hash, free_slot);
+            case CpuLevel::AVX2: return probe_avx2(key, hash, free_slot);
+            case CpuLevel::SSE42: return probe_sse42(key, hash, free_slot);
+#endif
+            default: return probe_groups<ScalarControlGroup>(key, hash, free_slot);
+        }
+    }
+
+    size_t find(const K& key) const {
+        return probe(key, hasher(key, capacity));
+    }
+
+public:
+    explicit SplitOpenAddrHashTable(size_t initial_capacity, std::function<size_t(const K&, size_t)> hashFunc,
+                                    MemoryPolicy policy = {})
+            : capacity(0), min_capacity(next_prime(initial_capacity)), size(0),
+              hasher(std::move(hashFunc)), memory_policy(policy) {
+        allocate(min_capacity);
+    }
+
+    ~SplitOpenAddrHashTable() {
+        release(control, keys, values, capacity);
+    }
+
+    void insert(const K& key, const V& value) override {
+        if ((size + 1) * 2 > capacity) {
+            rehash_up();
+        }
+        size_t hash = hasher(key, capacity);
+        size_t free_slot = capacity;
+        size_t index = probe(key, hash, &free_slot);
+        if (index != capacity) {
+            values[index] = value;
+            return;
+        }
+        if (free_slot == capacity)
+            throw std::overflow_error("HashTable is full");
+
+        control[free_slot] = fingerprint(hash);
+        keys[free_slot] = key;
+        values[free_slot] = value;
+        size++;
+    }
+
+    bool remove(const K& key) override {
+        size_t index = find(key);
+        if (index == capacity) return false;
+
+        control[index] = CTRL_DELETED;
+        size--;
+        if (size < capacity / 4 && capacity > min_capacity)
+            rehash_down();
+        return true;
+    }
+
+    // empties the table with one memset of the control bytes, keeping every array; keys and
+    // values left behind keep their buffers for the entries that reuse their slots
+    void clear() {
+        memset(control, CTRL_EMPTY, capacity);
+        size = 0;
+    }
+
+    // rehashes into the smallest capacity that holds the current entries, but not below the
+    // initial one
+    void shrink_to_fit() {
+        size_t fitted = std::max(min_capacity, next_prime(size * 2));
+        if (fitted < capacity) rehash(fitted);
+    }
+
+    V* getValue(const K& key) const override {
+        size_t index = find(key);
+        return index == capacity ? nullptr : &values[index];
+    }
+
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.entries = size;
+        usage.slots = capacity;
+        usage.arrays = slot_bytes<uint8_t>(capacity, memory_policy) + slot_bytes<K>(capacity, memory_policy)
+                       + slot_bytes<V>(capacity, memory_policy);
+        for (size_t i = 0; i < capacity; i++) {
+            usage.key_storage += heap_bytes(keys[i]);
+            usage.value_storage += heap_bytes(values[i]);
+        }
+        return usage;
+    }
+
+    void print() const override {
+        for (size_t i = 0; i < capacity; i++) {
+            std::cout << "[" << i << "]: ";
+            if (control[i] & CTRL_OCCUPIED)
+                std::cout << "(" << keys[i] << "," << values[i] << ")";
+            std::cout << "\n";
+        }
+    }
+};
+
+#endif //P3_SPLITOPENADDRHASHTABLE_H
@@ -0,0 +1,84 @@
+#ifndef P3_TIMERWHEEL_H
+#define P3_TIMERWHEEL_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hashed timer wheel: a timer due at tick t lives in slot t % slots.size(), so scheduling is O(1)
+// and advancing only visits the slots between the last processed tick and now. Timers further
+// than one revolution away stay in their slot until their round comes up.
+template<typename K>
+class TimerWheel {
+private:
+    struct Timer {
+        K key;
+        uint64_t deadline;
+    };
+
+    std::vector<std::vector<Timer>> slots;
+    uint64_t tick_ns;
+    uint64_t current_tick;
+
+public:
+    TimerWheel(uint64_t tick_ns, size_t num_slots, uint64_t now_ns)
+            : slots(num_slots), tick_ns(tick_ns), current_tick(now_ns / tick_ns) {}
+
+    void schedule(const K& key, uint64_t deadline_ns) {
+        uint64_t tick = deadline_ns / tick_ns;
+        if (tick < current_tick) tick = current_tick;
+        slots[tick % slots.size()].push_back({ key, deadline_ns });
+    }
+
+    // hands at most `budget` due timers to on_due(key, deadline) and returns how many it handed
+    // out; a call that runs out of budget resumes from the same tick next time
+    template<typename F>
+    size_t advance(uint64_t now_ns, size_t budget, F&& on_due) {
+        uint64_t now_tick = now_ns / tick_ns;
+        // after a long pause one revolution covers every slot, and due checks use the deadline
+        if (now_tick > current_tick && now_tick - current_tick >= slots.size())
+            current_tick = now_tick - slots.size() + 1;
+        size_t handled = 0;
+        while (current_tick <= now_tick) {
+            std::vector<Timer>& slot = slots[current_tick % slots.size()];
+            for (size_t i = 0; i < slot.size();) {
+                if (slot[i].deadline > now_ns) {
+                    i++;
+                    continue;
+                }
+                if (handled == budget) return handled;
+                Timer due = std::move(slot[i]);
+                slot[i] = std::move(slot.back());
+                slot.pop_back();
+                on_due(due.key, due.deadline);
+                handled++;
+            }
+            if (current_tick == now_tick) break;
+            current_tick++;
+        }
+        return handled;
+    }
+
+    // drops every pending timer; the slots keep their buffers
+    void clear() {
+        for (std::vector<Timer>& slot : slots)
+            slot.clear();
+    }
+
+    size_t memory_bytes() const {
+        size_t total = slots.capacity() * sizeof(std::vector<Timer>);
+        for (const auto& slot : slots)
+            total += slot.capacity() * sizeof(Timer);
+        return total;
+    }
+
+    size_t pending() const {
+        size_t total = 0;
+        for (const auto& slot : slots)
+            total += slot.size();
+        return total;
+    }
+};
+
+#endif //P3_TIMERWHEEL_H
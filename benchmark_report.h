@@ -0,0 +1,179 @@
+#ifndef P3_BENCHMARK_REPORT_H
+#define P3_BENCHMARK_REPORT_H
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// formats a measurement the way the CSV modes print doubles
+inline std::string report_number(double value) {
+    std::ostringstream text;
+    text << value;
+    return text.str();
+}
+
+// Writes benchmark rows either as the harness's usual `;`-separated CSV with a header line, or
+// as a JSON array with one object per row. Values are passed as text; in JSON the ones that parse
+// as numbers are written bare and everything else is quoted.
+class ReportWriter {
+private:
+    std::vector<std::string> columns;
+    bool json;
+    std::ostream& out;
+    size_t rows = 0;
+
+    static bool is_number(const std::string& value) {
+        if (value.empty()) return false;
+        char* end = nullptr;
+        std::strtod(value.c_str(), &end);
+        return *end == '\0' && value.find_first_of("nN") == std::string::npos;
+    }
+
+    static std::string quoted(const std::string& value) {
+        std::string result = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        return result + "\"";
+    }
+
+public:
+    ReportWriter(std::vector<std::string> columns, bool json, std::ostream& out = std::cout)
+            : columns(std::move(columns)), json(json), out(out) {
+        if (json) {
+            out << "[";
+            return;
+        }
+        for (size_t i = 0; i < this->columns.size(); i++)
+            out << (i ? "; " : "") << this->columns[i];
+        out << "\n";
+    }
+
+    ReportWriter(const ReportWriter&) = delete;
+    ReportWriter& operator=(const ReportWriter&) = delete;
+
+    ~ReportWriter() {
+        if (json) out << (rows ? "\n" : "") << "]\n";
+    }
+
+    void row(const std::vector<std::string>& values) {
+        if (json) {
+            out << (rows ? ",\n" : "\n") << "  {";
+            for (size_t i = 0; i < columns.size() && i < values.size(); i++) {
+                out << (i ? ", " : "") << quoted(columns[i]) << ": "
+                    << (is_number(values[i]) ? values[i] : quoted(values[i]));
+            }
+            out << "}";
+        } else {
+            for (size_t i = 0; i < values.size(); i++)
+                out << (i ? "; " : "") << values[i];
+            out << "\n";
+        }
+        rows++;
+    }
+};
+
+// Reads back what ReportWriter writes in JSON mode: an array of flat objects whose values are
+// strings or bare numbers. Numbers keep their text.
+inline std::vector<std::map<std::string, std::string>> read_report(std::istream& in) {
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t pos = 0;
+    auto skip_space = [&] {
+        while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    };
+    auto expect = [&](char c) {
+        skip_space();
+        if (pos >= text.size() || text[pos] != c)
+            throw std::runtime_error(std::string("report: expected '") + c + "' at offset " + std::to_string(pos));
+        pos++;
+    };
+    auto peek = [&] {
+        skip_space();
+        return pos < text.size() ? text[pos] : '\0';
+    };
+    auto read_value = [&] {
+        std::string value;
+        if (peek() != '"') {
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && !isspace(static_cast<unsigned char>(text[pos])))
+                value += text[pos++];
+            return value;
+        }
+        pos++;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\') pos++;
+            if (pos < text.size()) value += text[pos++];
+        }
+        expect('"');
+        return value;
+    };
+
+    std::vector<std::map<std::string, std::string>> rows;
+    expect('[');
+    while (peek() != ']') {
+        if (!rows.empty()) expect(',');
+        expect('{');
+        std::map<std::string, std::string> row;
+        while (peek() != '}') {
+            if (!row.empty()) expect(',');
+            std::string key = read_value();
+            expect(':');
+            row[key] = read_value();
+        }
+        expect('}');
+        rows.push_back(std::move(row));
+    }
+    expect(']');
+    return rows;
+}
+
+// mean and sample standard deviation of repeated measurements of one configuration
+struct SampleStats {
+    double mean = 0;
+    double stddev = 0;
+    size_t count = 0;
+
+    static SampleStats of(const std::vector<double>& samples) {
+        SampleStats stats;
+        stats.count = samples.size();
+        if (samples.empty()) return stats;
+        for (double x : samples) stats.mean += x;
+        stats.mean /= samples.size();
+        if (samples.size() > 1) {
+            double squares = 0;
+            for (double x : samples) squares += (x - stats.mean) * (x - stats.mean);
+            stats.stddev = std::sqrt(squares / (samples.size() - 1));
+        }
+        return stats;
+    }
+};
+
+// Welch's t-test between two sets of samples with possibly different variances: the t statistic
+// of b against a and whether it is significant at the two-sided 1% level
+inline std::pair<double, bool> welch_test(const SampleStats& a, const SampleStats& b) {
+    static constexpr double T_CRITICAL_1PCT[] = {
+        63.657, 9.925, 5.841, 4.604, 4.032, 3.707, 3.499, 3.355, 3.250, 3.169,
+        3.106, 3.055, 3.012, 2.977, 2.947, 2.921, 2.898, 2.878, 2.861, 2.845,
+        2.831, 2.819, 2.807, 2.797, 2.787, 2.779, 2.771, 2.763, 2.756, 2.750
+    };
+    if (a.count < 2 || b.count < 2) return { 0, false };
+    double va = a.stddev * a.stddev / a.count;
+    double vb = b.stddev * b.stddev / b.count;
+    if (va + vb == 0) return { 0, a.mean != b.mean };
+    double t = (b.mean - a.mean) / std::sqrt(va + vb);
+    double df = (va + vb) * (va + vb) / (va * va / (a.count - 1) + vb * vb / (b.count - 1));
+    size_t row = static_cast<size_t>(df);
+    double critical = row < 1 ? T_CRITICAL_1PCT[0] : row <= 30 ? T_CRITICAL_1PCT[row - 1] : 2.576;
+    return { t, std::fabs(t) > critical };
+}
+
+#endif //P3_BENCHMARK_REPORT_H
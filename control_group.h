@@ -0,0 +1,72 @@
+#ifndef P3_CONTROL_GROUP_H
+#define P3_CONTROL_GROUP_H
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Matches a run of WIDTH consecutive control bytes in one go, as SplitOpenAddrHashTable lays them
+// out: 0x00 is an empty slot, a set high bit an occupied one carrying a 7-bit fingerprint, and
+// anything else a deleted one. Bit i of each mask describes the byte at control + i.
+struct ControlMask {
+    uint64_t tag;     // occupied with the fingerprint looked for
+    uint64_t empty;
+    uint64_t free;    // empty or deleted
+};
+
+struct ScalarControlGroup {
+    static constexpr size_t WIDTH = 1;
+
+    static ControlMask match(const uint8_t* control, uint8_t tag) {
+        uint8_t c = *control;
+        return { c == tag, c == 0x00, (c & 0x80) == 0 };
+    }
+};
+
+#if defined(__x86_64__)
+struct Sse42ControlGroup {
+    static constexpr size_t WIDTH = 16;
+
+    __attribute__((target("sse4.2")))
+    static ControlMask match(const uint8_t* control, uint8_t tag) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        uint32_t tags = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(tag))));
+        uint32_t empty = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+        uint32_t occupied = _mm_movemask_epi8(bytes);
+        return { tags, empty, ~occupied & 0xFFFFu };
+    }
+};
+
+struct Avx2ControlGroup {
+    static constexpr size_t WIDTH = 32;
+
+    __attribute__((target("avx2")))
+    static ControlMask match(const uint8_t* control, uint8_t tag) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(control));
+        uint32_t tags = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(static_cast<char>(tag))));
+        uint32_t empty = _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_setzero_si256()));
+        uint32_t occupied = _mm256_movemask_epi8(bytes);
+        return { tags, empty, static_cast<uint32_t>(~occupied) };
+    }
+};
+
+// byte compares into mask registers are AVX-512BW
+struct Avx512ControlGroup {
+    static constexpr size_t WIDTH = 64;
+
+    __attribute__((target("avx512f,avx512bw")))
+    static ControlMask match(const uint8_t* control, uint8_t tag) {
+        __m512i bytes = _mm512_loadu_si512(control);
+        uint64_t tags = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8(static_cast<char>(tag)));
+        uint64_t empty = _mm512_cmpeq_epi8_mask(bytes, _mm512_setzero_si512());
+        uint64_t occupied = _mm512_movepi8_mask(bytes);
+        return { tags, empty, ~occupied };
+    }
+};
+#endif
+
+#endif //P3_CONTROL_GROUP_H
@@ -0,0 +1,61 @@
+#ifndef P3_CPU_DISPATCH_H
+#define P3_CPU_DISPATCH_H
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+// Instruction set tiers the SIMD kernels are built for. Every tier is compiled into the one
+// binary with target attributes; the best one the CPU supports is picked at startup, and the
+// P3_CPU_LEVEL environment variable (scalar, sse42, avx2 or avx512) can lower it for testing.
+enum class CpuLevel { SCALAR, SSE42, AVX2, AVX512 };
+
+inline const char* cpu_level_name(CpuLevel level) {
+    switch (level) {
+        case CpuLevel::SSE42: return "sse42";
+        case CpuLevel::AVX2: return "avx2";
+        case CpuLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+inline CpuLevel detected_cpu_level() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return CpuLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return CpuLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return CpuLevel::SSE42;
+#endif
+    return CpuLevel::SCALAR;
+}
+
+namespace cpu_dispatch_detail {
+    inline CpuLevel startup_level() {
+        CpuLevel level = detected_cpu_level();
+        const char* requested = std::getenv("P3_CPU_LEVEL");
+        if (!requested) return level;
+        // a tier above what the CPU supports is not honoured; unknown names leave the detected one
+        for (CpuLevel tier : { CpuLevel::SCALAR, CpuLevel::SSE42, CpuLevel::AVX2, CpuLevel::AVX512 }) {
+            if (strcmp(requested, cpu_level_name(tier)) == 0)
+                return tier < level ? tier : level;
+        }
+        return level;
+    }
+
+    inline CpuLevel active_level = startup_level();
+}
+
+// the tier the kernels dispatch on
+inline CpuLevel cpu_level() {
+    return cpu_dispatch_detail::active_level;
+}
+
+// switches every kernel to `level`, or to the best supported tier below it; returns the tier used
+inline CpuLevel set_cpu_level(CpuLevel level) {
+    CpuLevel detected = detected_cpu_level();
+    cpu_dispatch_detail::active_level = level < detected ? level : detected;
+    return cpu_dispatch_detail::active_level;
+}
+
+#endif //P3_CPU_DISPATCH_H
@@ -1,8 +1,19 @@
 #ifndef P3_HASH_FUNCTIONS_H
 #define P3_HASH_FUNCTIONS_H
 
-#include "ChainingHashTable.h"
+#include "cpu_dispatch.h"
 #include <math.h>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 struct AdditiveHash {
     size_t operator()(const std::string& key, size_t capacity) const {
@@ -24,12 +35,16 @@ struct MultiplicativeHash {
 };
 
 
+constexpr size_t djb2(std::string_view key) {
+    size_t hash = 5381;
+    for (char c : key)
+        hash = hash * 33 + c;
+    return hash;
+}
+
 struct DJB2Hash {
     size_t operator()(const std::string& key, size_t capacity) const {
-        size_t hash = 5381;
-        for (char c : key)
-            hash = hash * 33 + c;
-        return hash;
+        return djb2(key);
     }
 };
 
@@ -43,5 +58,217 @@ struct FibonacciHash {
     }
 };
 
+// Integer hashers: full-avalanche mixers, so a power-of-two table can use the low bits directly.
+struct IntegerMixHash {
+    constexpr size_t operator()(uint64_t key, size_t capacity = 0) const {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+};
+
+struct IntegerMultiplyShiftHash {
+    constexpr size_t operator()(uint64_t key, size_t capacity = 0) const {
+        key *= 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(key ^ (key >> 32));
+    }
+};
+
+// CRC32C (Castagnoli polynomial, reflected), the checksum SSE4.2's crc32 instruction computes.
+// Table k advances a byte's contribution by k further bytes, so a word takes 8 lookups in
+// parallel instead of a chain of 8 (slicing-by-8).
+constexpr std::array<std::array<uint32_t, 256>, 8> crc32c_tables() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? 0x82F63B78u : 0);
+        tables[0][i] = crc;
+    }
+    for (size_t k = 1; k < 8; k++) {
+        for (size_t i = 0; i < 256; i++)
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+    }
+    return tables;
+}
+
+inline constexpr std::array<std::array<uint32_t, 256>, 8> CRC32C_TABLES = crc32c_tables();
+
+// what one crc32 instruction does to a little-endian 64-bit word
+constexpr uint32_t crc32c_word(uint32_t crc, uint64_t word) {
+    const auto& t = CRC32C_TABLES;
+    uint32_t low = crc ^ static_cast<uint32_t>(word);
+    uint32_t high = static_cast<uint32_t>(word >> 32);
+    return t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+           ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+}
+
+// For trusted keys: the key is read 8 bytes at a time, even words into one CRC and odd words
+// into another so the two latency chains overlap, and the final partial word zero-padded. CRC is
+// linear, so the result is run through IntegerMixHash with the length, which gives every output
+// bit, the low ones a table indexes by included, a dependence on every key bit. The crc32
+// instruction is used from the SSE4.2 tier up, a table-driven CRC below it; both agree bit for bit.
+struct CRC32CHash {
+    static constexpr uint32_t EVEN_SEED = 0xFFFFFFFFu;
+    static constexpr uint32_t ODD_SEED = 0x9E3779B9u;
+
+    static uint64_t load_word(const char* data) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        return word;
+    }
+
+    // the last 1 to 8 bytes of the key from offset on, zero-padded, without a byte loop: a key of
+    // 8 bytes or more is read as its final 8 bytes shifted down, a shorter one as two overlapping
+    // 4-byte reads or, under 4 bytes, as its first, middle and last byte
+    static uint64_t tail_word(const char* data, size_t offset, size_t length) {
+        size_t rest = length - offset;
+        if (length >= 8)
+            return load_word(data + length - 8) >> (8 * (8 - rest));
+        if (rest >= 4) {
+            uint32_t low, high;
+            memcpy(&low, data, 4);
+            memcpy(&high, data + rest - 4, 4);
+            return low | static_cast<uint64_t>(high) << (8 * (rest - 4));
+        }
+        return static_cast<uint64_t>(static_cast<uint8_t>(data[0]))
+               | static_cast<uint64_t>(static_cast<uint8_t>(data[rest / 2])) << (8 * (rest / 2))
+               | static_cast<uint64_t>(static_cast<uint8_t>(data[rest - 1])) << (8 * (rest - 1));
+    }
+
+    static size_t finish(uint32_t even, uint32_t odd, size_t length) {
+        uint64_t combined = static_cast<uint64_t>(even) << 32 | odd;
+        return IntegerMixHash()(combined ^ length * 0x9E3779B97F4A7C15ULL);
+    }
+
+    static size_t software(const std::string& key) {
+        const char* data = key.data();
+        size_t length = key.size();
+        uint32_t even = EVEN_SEED, odd = ODD_SEED;
+        size_t offset = 0;
+        for (; offset + 16 <= length; offset += 16) {
+            even = crc32c_word(even, load_word(data + offset));
+            odd = crc32c_word(odd, load_word(data + offset + 8));
+        }
+        if (offset + 8 <= length) {
+            even = crc32c_word(even, load_word(data + offset));
+            offset += 8;
+            if (offset < length) odd = crc32c_word(odd, tail_word(data, offset, length));
+        } else if (offset < length) {
+            even = crc32c_word(even, tail_word(data, offset, length));
+        }
+        return finish(even, odd, length);
+    }
+
+#if defined(__x86_64__)
+    __attribute__((target("sse4.2")))
+    static size_t hardware(const std::string& key) {
+        const char* data = key.data();
+        size_t length = key.size();
+        uint32_t even = EVEN_SEED, odd = ODD_SEED;
+        size_t offset = 0;
+        for (; offset + 16 <= length; offset += 16) {
+            even = static_cast<uint32_t>(_mm_crc32_u64(even, load_word(data + offset)));
+            odd = static_cast<uint32_t>(_mm_crc32_u64(odd, load_word(data + offset + 8)));
+        }
+        if (offset + 8 <= length) {
+            even = static_cast<uint32_t>(_mm_crc32_u64(even, load_word(data + offset)));
+            offset += 8;
+            if (offset < length) odd = static_cast<uint32_t>(_mm_crc32_u64(odd, tail_word(data, offset, length)));
+        } else if (offset < length) {
+            even = static_cast<uint32_t>(_mm_crc32_u64(even, tail_word(data, offset, length)));
+        }
+        return finish(even, odd, length);
+    }
+#endif
+
+    size_t operator()(const std::string& key, size_t /*capacity*/) const {
+#if defined(__x86_64__)
+        if (cpu_level() >= CpuLevel::SSE42) return hardware(key);
+#endif
+        return software(key);
+    }
+};
+
+// Keyed hashers for untrusted input: without the seed an attacker cannot predict bucket indices.
+struct HashSeed {
+    uint64_t k0 = 0;
+    uint64_t k1 = 0;
+
+    static HashSeed random() {
+        std::random_device device;
+        HashSeed seed;
+        seed.k0 = (static_cast<uint64_t>(device()) << 32) ^ device();
+        seed.k1 = (static_cast<uint64_t>(device()) << 32) ^ device();
+        return seed;
+    }
+};
+
+// Decides when a keyed table reseeds. A random seed still yields chains and probe sequences
+// that grow like log2(n), so the limit is the user's threshold plus that, and a reseed is only
+// allowed once as many inserts as the table holds have happened since the last one, which keeps
+// its O(n) rehash amortized O(1) per insert whatever the keys.
+struct ReseedTrigger {
+    size_t threshold = 0;   // 0 = never reseed
+    size_t inserts = 0;     // since the last reseed
+
+    bool due(size_t length, size_t size) {
+        if (threshold == 0) return false;
+        inserts++;
+        return length > threshold + std::bit_width(size) && inserts >= size;
+    }
+
+    void reset() { inserts = 0; }
+};
+
+// SipHash-2-4 (Aumasson & Bernstein)
+struct SipHash {
+    static uint64_t rotl(uint64_t x, int b) {
+        return (x << b) | (x >> (64 - b));
+    }
+
+    static void round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+
+    size_t operator()(const std::string& key, size_t /*capacity*/, const HashSeed& seed) const {
+        uint64_t v0 = seed.k0 ^ 0x736f6d6570736575ULL;
+        uint64_t v1 = seed.k1 ^ 0x646f72616e646f6dULL;
+        uint64_t v2 = seed.k0 ^ 0x6c7967656e657261ULL;
+        uint64_t v3 = seed.k1 ^ 0x7465646279746573ULL;
+
+        const char* data = key.data();
+        size_t length = key.size();
+        size_t blocks = length / 8;
+        for (size_t i = 0; i < blocks; i++) {
+            uint64_t m;
+            memcpy(&m, data + i * 8, 8);
+            v3 ^= m;
+            round(v0, v1, v2, v3);
+            round(v0, v1, v2, v3);
+            v0 ^= m;
+        }
+
+        uint64_t last = static_cast<uint64_t>(length) << 56;
+        for (size_t i = 0; i < length % 8; i++)
+            last |= static_cast<uint64_t>(static_cast<unsigned char>(data[blocks * 8 + i])) << (8 * i);
+        v3 ^= last;
+        round(v0, v1, v2, v3);
+        round(v0, v1, v2, v3);
+        v0 ^= last;
+
+        v2 ^= 0xff;
+        for (int i = 0; i < 4; i++)
+            round(v0, v1, v2, v3);
+        return static_cast<size_t>(v0 ^ v1 ^ v2 ^ v3);
+    }
+};
+
 
 #endif //P3_HASH_FUNCTIONS_H
@@ -0,0 +1,129 @@
+#ifndef P3_HASH_MANY_H
+#define P3_HASH_MANY_H
+#pragma once
+
+#include "cpu_dispatch.h"
+#include "hash_functions.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Batch DJB2: hash_many(keys, out) sets out[i] = DJB2Hash()(keys[i], cap) for every i, bit for
+// bit, so a table using DJB2Hash can hash a whole batch at once. Keys are hashed side by side in
+// the 64-bit lanes of a vector, since hash * 33 is a shift and an add: four at a time with AVX2
+// and eight with AVX-512, picked by cpu_level(). Below AVX2 it is a plain loop, which
+// beat two SSE lanes.
+
+inline void djb2_many_scalar(std::span<const std::string> keys, std::span<size_t> out) {
+    for (size_t i = 0; i < keys.size(); i++)
+        out[i] = djb2(keys[i]);
+}
+
+#if defined(__x86_64__)
+// bytes [offset, offset + 8) of key as a little-endian word, zero past the end of the key; a
+// partial last word of a key of 8 bytes or more is read as the key's final 8 bytes and shifted
+inline uint64_t load_key_word(const std::string& key, size_t offset) {
+    uint64_t word = 0;
+    size_t size = key.size();
+    if (offset + 8 <= size) {
+        memcpy(&word, key.data() + offset, 8);
+    } else if (size >= 8) {
+        if (offset < size) {
+            memcpy(&word, key.data() + size - 8, 8);
+            word >>= 8 * (offset + 8 - size);
+        }
+    } else {
+        for (size_t i = size; i-- > offset;)
+            word = (word << 8) | static_cast<uint8_t>(key[i]);
+    }
+    return word;
+}
+
+__attribute__((target("avx2")))
+inline void djb2_many_avx2(std::span<const std::string> keys, std::span<size_t> out) {
+    const __m256i low_byte = _mm256_set1_epi64x(0xFF);
+    const __m256i sign_bit = _mm256_set1_epi64x(std::is_signed_v<char> ? 0x80 : 0);
+    const __m256i one = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    for (; i + 4 <= keys.size(); i += 4) {
+        const std::string* k = &keys[i];
+        const __m256i lengths = _mm256_set_epi64x(k[3].size(), k[2].size(), k[1].size(), k[0].size());
+        size_t longest = std::max({ k[0].size(), k[1].size(), k[2].size(), k[3].size() });
+        __m256i hash = _mm256_set1_epi64x(5381);
+        for (size_t offset = 0; offset < longest; offset += 8) {
+            __m256i words = _mm256_set_epi64x(load_key_word(k[3], offset), load_key_word(k[2], offset),
+                                              load_key_word(k[1], offset), load_key_word(k[0], offset));
+            // bytes left in each lane's key from this word on; a lane only advances while positive
+            __m256i remaining = _mm256_sub_epi64(lengths, _mm256_set1_epi64x(offset));
+            for (size_t b = 0; b < 8; b++) {
+                // char is widened the way the scalar loop does: sign-extended where char is signed
+                __m256i c = _mm256_and_si256(words, low_byte);
+                c = _mm256_sub_epi64(_mm256_xor_si256(c, sign_bit), sign_bit);
+                words = _mm256_srli_epi64(words, 8);
+
+                __m256i next = _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(hash, 5), hash), c);
+                hash = _mm256_blendv_epi8(hash, next, _mm256_cmpgt_epi64(remaining, _mm256_setzero_si256()));
+                remaining = _mm256_sub_epi64(remaining, one);
+            }
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[i]), hash);
+    }
+    djb2_many_scalar(keys.subspan(i), out.subspan(i));
+}
+
+// AVX-512F: the lane mask comes straight out of the compare and drives a masked move. Shifts use
+// the zero-masking forms with every lane selected, which GCC 12 does not mistake for reads of
+// uninitialized vectors the way it does the plain ones.
+__attribute__((target("avx512f")))
+inline void djb2_many_avx512(std::span<const std::string> keys, std::span<size_t> out) {
+    const __m512i low_byte = _mm512_set1_epi64(0xFF);
+    const __m512i sign_bit = _mm512_set1_epi64(std::is_signed_v<char> ? 0x80 : 0);
+    const __m512i one = _mm512_set1_epi64(1);
+    size_t i = 0;
+    for (; i + 8 <= keys.size(); i += 8) {
+        const std::string* k = &keys[i];
+        const __m512i lengths = _mm512_set_epi64(k[7].size(), k[6].size(), k[5].size(), k[4].size(),
+                                                 k[3].size(), k[2].size(), k[1].size(), k[0].size());
+        size_t longest = 0;
+        for (size_t j = 0; j < 8; j++) longest = std::max(longest, k[j].size());
+        __m512i hash = _mm512_set1_epi64(5381);
+        for (size_t offset = 0; offset < longest; offset += 8) {
+            __m512i words = _mm512_set_epi64(load_key_word(k[7], offset), load_key_word(k[6], offset),
+                                             load_key_word(k[5], offset), load_key_word(k[4], offset),
+                                             load_key_word(k[3], offset), load_key_word(k[2], offset),
+                                             load_key_word(k[1], offset), load_key_word(k[0], offset));
+            __m512i remaining = _mm512_sub_epi64(lengths, _mm512_set1_epi64(offset));
+            for (size_t b = 0; b < 8; b++) {
+                __m512i c = _mm512_and_si512(words, low_byte);
+                c = _mm512_sub_epi64(_mm512_xor_si512(c, sign_bit), sign_bit);
+                words = _mm512_maskz_srli_epi64(0xFF, words, 8);
+
+                __m512i next = _mm512_add_epi64(_mm512_add_epi64(_mm512_maskz_slli_epi64(0xFF, hash, 5), hash), c);
+                hash = _mm512_mask_mov_epi64(hash, _mm512_cmpgt_epi64_mask(remaining, _mm512_setzero_si512()), next);
+                remaining = _mm512_sub_epi64(remaining, one);
+            }
+        }
+        _mm512_storeu_si512(&out[i], hash);
+    }
+    djb2_many_avx2(keys.subspan(i), out.subspan(i));
+}
+#endif
+
+inline void hash_many(std::span<const std::string> keys, std::span<size_t> out) {
+    switch (cpu_level()) {
+#if defined(__x86_64__)
+        case CpuLevel::AVX512: return djb2_many_avx512(keys, out);
+        case CpuLevel::AVX2: return djb2_many_avx2(keys, out);
+#endif
+        default: return djb2_many_scalar(keys, out);
+    }
+}
+
+#endif //P3_HASH_MANY_H
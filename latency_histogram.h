@@ -0,0 +1,100 @@
+#ifndef P3_LATENCY_HISTOGRAM_H
+#define P3_LATENCY_HISTOGRAM_H
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// HDR-style histogram of nanosecond latencies. Values below 2 * SUB_BUCKETS are counted exactly;
+// above that every power-of-two range is split into SUB_BUCKETS linear buckets, so any recorded
+// value is reported within 1 / SUB_BUCKETS of itself (0.4%) across the whole 64-bit range, in a
+// fixed 115 KB of counters.
+class LatencyHistogram {
+private:
+    static constexpr unsigned SUB_BUCKET_BITS = 8;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+    long double sum = 0;
+
+    static size_t index_of(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) return value;
+        unsigned shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + (value >> shift);
+    }
+
+    // largest value that lands in the bucket at `index`
+    static uint64_t highest_value(size_t index) {
+        if (index < 2 * SUB_BUCKETS) return index;
+        unsigned shift = index / SUB_BUCKETS - 1;
+        uint64_t sub = index % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(index_of(UINT64_MAX) + 1, 0) {}
+
+    void record(uint64_t value) {
+        counts[index_of(value)]++;
+        total++;
+        sum += value;
+        max_value = std::max(max_value, value);
+    }
+
+    // the latency that `quantile` of the recorded values are at or below, rounded up to the top of
+    // its bucket
+    uint64_t percentile(double quantile) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(quantile * total + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(highest_value(i), max_value);
+        }
+        return max_value;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return max_value; }
+    double mean() const { return total ? static_cast<double>(sum / total) : 0; }
+};
+
+// Times single operations with steady_clock and subtracts the cost of reading the clock twice,
+// calibrated once as the median of back-to-back reads.
+class LatencyTimer {
+private:
+    uint64_t overhead_ns = 0;
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+public:
+    LatencyTimer() {
+        std::vector<uint64_t> samples(10000);
+        for (uint64_t& sample : samples) {
+            uint64_t start = now_ns();
+            sample = now_ns() - start;
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        overhead_ns = samples[samples.size() / 2];
+    }
+
+    uint64_t overhead() const { return overhead_ns; }
+
+    template<typename F>
+    void time(LatencyHistogram& histogram, F&& operation) const {
+        uint64_t start = now_ns();
+        operation();
+        uint64_t elapsed = now_ns() - start;
+        histogram.record(elapsed > overhead_ns ? elapsed - overhead_ns : 0);
+    }
+};
+
+#endif //P3_LATENCY_HISTOGRAM_H
@@ -1,11 +1,29 @@
 #include "ChainingHashTable.h"
 #include "hash_functions.h"
+#include "SplitOpenAddrHashTable.h"
+#include "IntegerHashTable.h"
+#include "CuckooHashTable.h"
+#include "HopscotchHashTable.h"
+#include "ConcurrentHashTable.h"
+#include "RcuHashTable.h"
+#include "PerfectHashTable.h"
+#include "benchmark_report.h"
+#include "latency_histogram.h"
+#include "perf_counters.h"
+#include "hash_many.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
+#include <cmath>
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+#include <array>
+#include <fstream>
+#include <map>
 #define NUM_TESTS 50
 
 using namespace std;
@@ -26,31 +44,37 @@ std::vector<std::string> generateDeterministicKeys(size_t n) {
     return keys;
 }
 
-int main() {
-    srand((time(NULL)));
-
-    using HashFunction = std::function<size_t(const std::string&, size_t)>;
+using HashFunction = std::function<size_t(const std::string&, size_t)>;
 
-    std::vector<std::pair<std::string, HashFunction>> hashFunctions = {
+std::vector<std::pair<std::string, HashFunction>> makeHashFunctions() {
+    return {
             { "AdditiveHash", [](const std::string& key, size_t cap) { return AdditiveHash()(key, cap); } },
             { "DJB2Hash", [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); } },
             { "FibonacciHash", [](const std::string& key, size_t cap) { return FibonacciHash()(key, cap); } },
-            { "MultiplicativeHash", [](const std::string& key, size_t cap) { return MultiplicativeHash()(key, cap); } }
+            { "MultiplicativeHash", [](const std::string& key, size_t cap) { return MultiplicativeHash()(key, cap); } },
+            { "CRC32CHash", [](const std::string& key, size_t cap) { return CRC32CHash()(key, cap); } }
     };
+}
+
+void runSweep() {
+    auto hashFunctions = makeHashFunctions();
 
     float percentages[] = { 0.10, 0.25, 0.33, 0.50, 0.75, 1.00};
     const std::vector<size_t> sizes = {10, 50, 100, 500, 1000, 5000, 10000, 50000};
 
-    cout << "Percentage; Initial_size; Function; Time_Insert_Ch; Time_Insert_OA; Time_Remove_Ch; Time_Remove_OA\n";
+    cout << "Percentage; Initial_size; Function; Time_Insert_Ch; Time_Insert_OA; Time_Insert_Cu; Time_Remove_Ch; Time_Remove_OA; Time_Remove_Cu\n";
     for(auto percentage : percentages) {
         for (auto &[name, hashFunc]: hashFunctions) {
             for (auto size: sizes) {
                 auto tableCh = new ChainingHashTable<string, int>(size, hashFunc);
                 auto tableOA = new OpenAddrHashTable<string, int>(size, hashFunc);
+                auto tableCu = new CuckooHashTable<string, int>(size, hashFunc);
                 double timerChInsert = 0;
                 double timerOAInsert = 0;
+                double timerCuInsert = 0;
                 double timerChRemove = 0;
                 double timerOARemove = 0;
+                double timerCuRemove = 0;
                 for (int i = 0; i < NUM_TESTS; i++) {
                     std::string key;
                     int value;
@@ -59,6 +83,7 @@ int main() {
                         value = rand() % 1000;
                         tableCh->insert(key, value);
                         tableOA->insert(key, value);
+                        tableCu->insert(key, value);
                     }
 
                     string key_insert = generateKey();
@@ -73,8 +98,14 @@ int main() {
                     stop = chrono::high_resolution_clock::now();
                     timerOAInsert += chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
 
+                    start = chrono::high_resolution_clock::now();
+                    tableCu->insert(key_insert, value);
+                    stop = chrono::high_resolution_clock::now();
+                    timerCuInsert += chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+
                     tableCh->remove(key_insert);
                     tableOA->remove(key_insert);
+                    tableCu->remove(key_insert);
 
 
                     start = chrono::high_resolution_clock::now();
@@ -86,20 +117,1244 @@ int main() {
                     tableOA->remove(key);
                     stop = chrono::high_resolution_clock::now();
                     timerOARemove += chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+
+                    start = chrono::high_resolution_clock::now();
+                    tableCu->remove(key);
+                    stop = chrono::high_resolution_clock::now();
+                    timerCuRemove += chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
                 }
                 timerChInsert /= NUM_TESTS;
                 timerOAInsert /= NUM_TESTS;
+                timerCuInsert /= NUM_TESTS;
                 timerChRemove /= NUM_TESTS;
                 timerOARemove /= NUM_TESTS;
+                timerCuRemove /= NUM_TESTS;
                 cout << percentage << "; " << size << "; " << name << "; "
-                     << timerChInsert << "; " << timerOAInsert << "; " << timerChRemove << "; " << timerOARemove
+                     << timerChInsert << "; " << timerOAInsert << "; " << timerCuInsert << "; "
+                     << timerChRemove << "; " << timerOARemove << "; " << timerCuRemove
                      << "\n";
                 delete tableCh;
                 delete tableOA;
+                delete tableCu;
+            }
+        }
+    }
+}
+
+// the key sequence is drawn before the clock starts, so only the lookups are timed
+template<typename Table, typename Key>
+double measureLookups(Table& table, const std::vector<Key>& keys, size_t lookups, bool expectHits = true) {
+    std::mt19937 rng(42);
+    std::vector<size_t> sequence(lookups);
+    for (size_t& index : sequence)
+        index = rng() % keys.size();
+
+    size_t found = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t index : sequence) {
+        if (table.getValue(keys[index]) != nullptr)
+            found++;
+    }
+    auto stop = chrono::high_resolution_clock::now();
+    if (expectHits && found != lookups)
+        cerr << "lookup benchmark: " << lookups - found << " keys not found\n";
+    if (!expectHits && found != 0)
+        cerr << "lookup benchmark: " << found << " absent keys found\n";
+    double seconds = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e9;
+    return lookups / seconds;
+}
+
+void runHugePageBenchmark() {
+    // ~2M slots of 40 bytes each span far more than the dTLB reach of 4 KiB pages
+    const size_t numKeys = 1000000;
+    const size_t numLookups = 5000000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    std::vector<std::pair<std::string, MemoryPolicy>> policies = {
+            { "Default", {} },
+            { "TransparentHuge", { PageMode::TRANSPARENT_HUGE } },
+            { "ExplicitHuge", { PageMode::EXPLICIT_HUGE } },
+            { "TransparentHugeInterleave", { PageMode::TRANSPARENT_HUGE, NumaMode::INTERLEAVE } }
+    };
+
+    cout << "Policy; Keys; Lookups_per_sec_Ch; Lookups_per_sec_OA\n";
+    for (auto &[name, policy]: policies) {
+        ChainingHashTable<string, int> tableCh(2 * numKeys, hashFunc, policy);
+        OpenAddrHashTable<string, int> tableOA(2 * numKeys, hashFunc, policy);
+        for (size_t i = 0; i < numKeys; i++) {
+            tableCh.insert(keys[i], static_cast<int>(i));
+            tableOA.insert(keys[i], static_cast<int>(i));
+        }
+        double throughputCh = measureLookups(tableCh, keys, numLookups);
+        double throughputOA = measureLookups(tableOA, keys, numLookups);
+        cout << name << "; " << numKeys << "; " << throughputCh << "; " << throughputOA << "\n";
+    }
+}
+
+struct Payload {
+    char bytes[200] = {};
+};
+
+std::ostream& operator<<(std::ostream& os, const Payload&) {
+    return os << "<payload>";
+}
+
+void runLayoutBenchmark() {
+    const size_t numKeys = 200000;
+    const size_t numLookups = 2000000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    OpenAddrHashTable<string, Payload> tableOA(2 * numKeys, hashFunc);
+    SplitOpenAddrHashTable<string, Payload> tableSplit(2 * numKeys, hashFunc);
+    Payload payload;
+    for (size_t i = 0; i < numKeys; i++) {
+        tableOA.insert(keys[i], payload);
+        tableSplit.insert(keys[i], payload);
+    }
+
+    cout << "Keys; Value_bytes; Lookups_per_sec_OA; Lookups_per_sec_Split\n";
+    cout << numKeys << "; " << sizeof(Payload) << "; "
+         << measureLookups(tableOA, keys, numLookups) << "; "
+         << measureLookups(tableSplit, keys, numLookups) << "\n";
+}
+
+void runIntegerKeyBenchmark() {
+    const size_t numKeys = 1000000;
+    const size_t numLookups = 10000000;
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < numKeys; i++)
+        keys.push_back((static_cast<uint64_t>(rand()) << 32) ^ rand());
+
+    auto hashFunc = [](const uint64_t& key, size_t cap) { return IntegerMixHash()(key, cap); };
+    OpenAddrHashTable<uint64_t, int> tableOA(2 * numKeys, hashFunc);
+    IntegerHashTable<uint64_t, int> tableInt(2 * numKeys);
+    for (size_t i = 0; i < numKeys; i++) {
+        tableOA.insert(keys[i], static_cast<int>(i));
+        tableInt.insert(keys[i], static_cast<int>(i));
+    }
+
+    cout << "Keys; Lookups_per_sec_OA; Lookups_per_sec_Int\n";
+    cout << numKeys << "; " << measureLookups(tableOA, keys, numLookups) << "; "
+         << measureLookups(tableInt, keys, numLookups) << "\n";
+}
+
+void runDensityBenchmark() {
+    const size_t numKeys = 500000;
+    const size_t numLookups = 5000000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    // sized so that the hopscotch table ends up around 0.9 load without resizing
+    OpenAddrHashTable<string, int> tableOA(2 * numKeys, hashFunc);
+    HopscotchHashTable<string, int> tableHop(numKeys * 10 / 9 + 1, hashFunc);
+    for (size_t i = 0; i < numKeys; i++) {
+        tableOA.insert(keys[i], static_cast<int>(i));
+        tableHop.insert(keys[i], static_cast<int>(i));
+    }
+
+    cout << "Keys; Load_Hop; Lookups_per_sec_OA; Lookups_per_sec_Hop\n";
+    cout << numKeys << "; " << tableHop.load_factor() << "; "
+         << measureLookups(tableOA, keys, numLookups) << "; "
+         << measureLookups(tableHop, keys, numLookups) << "\n";
+}
+
+template<typename Probe>
+double measureProbing(const HashFunction& hashFunc, const std::vector<std::string>& keys, Probe probe) {
+    OpenAddrHashTable<string, int, Probe> table(2 * keys.size(), hashFunc, {}, probe);
+    for (size_t i = 0; i < keys.size(); i++)
+        table.insert(keys[i], static_cast<int>(i));
+    return measureLookups(table, keys, 10 * keys.size());
+}
+
+void runProbingBenchmark() {
+    const size_t numKeys = 20000;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < numKeys; i++)
+        keys.push_back(generateKey());
+
+    DoubleHashProbe<string> doubleHash;
+    doubleHash.second_hasher = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap) >> 7; };
+
+    cout << "Function; Keys; Lookups_per_sec_Linear; Lookups_per_sec_Quadratic; Lookups_per_sec_Double\n";
+    for (auto &[name, hashFunc]: makeHashFunctions()) {
+        cout << name << "; " << numKeys << "; "
+             << measureProbing(hashFunc, keys, LinearProbe()) << "; "
+             << measureProbing(hashFunc, keys, QuadraticProbe()) << "; "
+             << measureProbing(hashFunc, keys, doubleHash) << "\n";
+    }
+}
+
+// "Aa" and "B@" have the same DJB2 contribution, so any concatenation of n such blocks gives
+// 2^n keys that collide in every table using DJB2Hash
+std::vector<std::string> generateDJB2Collisions(size_t blocks) {
+    std::vector<std::string> keys;
+    for (size_t mask = 0; mask < (size_t(1) << blocks); mask++) {
+        std::string key;
+        for (size_t b = 0; b < blocks; b++)
+            key += (mask >> b) & 1 ? "B@" : "Aa";
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+template<typename Table>
+double measureInsertAll(Table& table, const std::vector<std::string>& keys) {
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < keys.size(); i++)
+        table.insert(keys[i], static_cast<int>(i));
+    auto stop = chrono::high_resolution_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e6;
+}
+
+void runFloodingBenchmark() {
+    auto keys = generateDJB2Collisions(13);
+    auto djb2 = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+    auto sip = [](const std::string& key, size_t cap, const HashSeed& seed) { return SipHash()(key, cap, seed); };
+
+    ChainingHashTable<string, int> tableDJB2(16, djb2);
+    ChainingHashTable<string, int> tableSip(16, sip, 16);
+    double insertDJB2 = measureInsertAll(tableDJB2, keys);
+    double insertSip = measureInsertAll(tableSip, keys);
+
+    cout << "Colliding_keys; Insert_ms_DJB2; Insert_ms_SipHash; Lookups_per_sec_DJB2; Lookups_per_sec_SipHash\n";
+    cout << keys.size() << "; " << insertDJB2 << "; " << insertSip << "; "
+         << measureLookups(tableDJB2, keys, 100000) << "; "
+         << measureLookups(tableSip, keys, 100000) << "\n";
+
+    // ordinary keys still produce the odd long chain or probe run under a random seed; the
+    // reseed trigger has to keep that from turning into back-to-back rehashes
+    auto ordinary = generateDeterministicKeys(1000000);
+    cout << "\nOrdinary_keys; Table; Reseed_after; Insert_ms; Reseeds\n";
+    for (size_t reseedAfter : { 0, 4, 16 }) {
+        ChainingHashTable<string, int> tableCh(16, sip, reseedAfter);
+        OpenAddrHashTable<string, int> tableOA(16, sip, reseedAfter);
+        double insertCh = measureInsertAll(tableCh, ordinary);
+        double insertOA = measureInsertAll(tableOA, ordinary);
+        cout << ordinary.size() << "; Ch; " << reseedAfter << "; " << insertCh << "; " << tableCh.reseeds() << "\n";
+        cout << ordinary.size() << "; OA; " << reseedAfter << "; " << insertOA << "; " << tableOA.reseeds() << "\n";
+    }
+}
+
+// readers hammer a preloaded key set while one writer grows the table through several resizes;
+// reports the worst single lookup each reader saw
+template<typename Lookup, typename Insert>
+void measureReaderStalls(const string& name, const std::vector<std::string>& keys, size_t preloaded,
+                         Lookup lookup, Insert insert) {
+    const int numReaders = 3;
+    std::atomic<bool> writing{ true };
+    std::vector<double> worst(numReaders, 0);
+    std::vector<size_t> reads(numReaders, 0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < numReaders; r++) {
+        readers.emplace_back([&, r] {
+            size_t i = r;
+            while (writing.load()) {
+                auto start = chrono::steady_clock::now();
+                lookup(keys[i % preloaded]);
+                auto stop = chrono::steady_clock::now();
+                worst[r] = max(worst[r], (double) chrono::duration_cast<chrono::nanoseconds>(stop - start).count());
+                reads[r]++;
+                i += numReaders;
+            }
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = preloaded; i < keys.size(); i++)
+        insert(keys[i], static_cast<int>(i));
+    auto stop = chrono::steady_clock::now();
+    writing.store(false);
+    for (auto& t : readers) t.join();
+
+    double worstAll = 0;
+    size_t readsAll = 0;
+    for (int r = 0; r < numReaders; r++) {
+        worstAll = max(worstAll, worst[r]);
+        readsAll += reads[r];
+    }
+    cout << name << "; " << keys.size() << "; "
+         << chrono::duration_cast<chrono::milliseconds>(stop - start).count() << "; "
+         << readsAll << "; " << worstAll / 1e6 << "\n";
+}
+
+void runConcurrentBenchmark() {
+    const size_t numKeys = 400000;
+    const size_t preloaded = 1000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    cout << "Table; Keys; Insert_ms; Reads_during_inserts; Worst_read_ms\n";
+
+    ChainingHashTable<string, int> tableCh(16, hashFunc);
+    std::shared_mutex lock;
+    for (size_t i = 0; i < preloaded; i++)
+        tableCh.insert(keys[i], static_cast<int>(i));
+    measureReaderStalls("Chaining+shared_mutex", keys, preloaded,
+                        [&](const std::string& key) {
+                            std::shared_lock<std::shared_mutex> guard(lock);
+                            return tableCh.getValue(key) != nullptr;
+                        },
+                        [&](const std::string& key, int value) {
+                            std::unique_lock<std::shared_mutex> guard(lock);
+                            tableCh.insert(key, value);
+                        });
+
+    ConcurrentHashTable<string, int> tableCo(16, hashFunc);
+    for (size_t i = 0; i < preloaded; i++)
+        tableCo.insert(keys[i], static_cast<int>(i));
+    measureReaderStalls("Concurrent", keys, preloaded,
+                        [&](const std::string& key) { return tableCo.getValue(key).has_value(); },
+                        [&](const std::string& key, int value) { tableCo.insert(key, value); });
+}
+
+// readers look up keys for a fixed period while a writer rebuilds the table every 50 ms
+template<typename MakeReader, typename Rebuild>
+double measureReadScaling(int numReaders, MakeReader makeReader, Rebuild rebuild,
+                          const std::vector<std::string>& keys) {
+    std::atomic<bool> running{ true };
+    std::atomic<size_t> totalReads{ 0 };
+    std::vector<std::thread> readers;
+    for (int r = 0; r < numReaders; r++) {
+        readers.emplace_back([&, r] {
+            auto lookup = makeReader();
+            size_t reads = 0;
+            for (size_t i = r; running.load(std::memory_order_relaxed); i += numReaders) {
+                lookup(keys[i % keys.size()]);
+                reads++;
+            }
+            totalReads += reads;
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    while (chrono::steady_clock::now() - start < chrono::seconds(1)) {
+        rebuild();
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    running.store(false);
+    for (auto& t : readers) t.join();
+    double seconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() / 1e9;
+    return totalReads.load() / seconds;
+}
+
+void runRcuBenchmark() {
+    const size_t numKeys = 10000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+    auto fill = [&](OpenAddrHashTable<string, int>& table) {
+        for (size_t i = 0; i < numKeys; i++)
+            table.insert(keys[i], static_cast<int>(i));
+    };
+
+    cout << "Readers; Reads_per_sec_shared_mutex; Reads_per_sec_RCU\n";
+    unsigned maxReaders = max(2u, thread::hardware_concurrency());
+    for (unsigned readers = 1; readers <= maxReaders; readers *= 2) {
+        std::unique_ptr<OpenAddrHashTable<string, int>> locked = make_unique<OpenAddrHashTable<string, int>>(2 * numKeys, hashFunc);
+        fill(*locked);
+        std::shared_mutex lock;
+        double lockedRate = measureReadScaling(readers,
+                [&] {
+                    return [&](const std::string& key) {
+                        std::shared_lock<std::shared_mutex> guard(lock);
+                        return locked->getValue(key) != nullptr;
+                    };
+                },
+                [&] {
+                    auto next = make_unique<OpenAddrHashTable<string, int>>(2 * numKeys, hashFunc);
+                    fill(*next);
+                    std::unique_lock<std::shared_mutex> guard(lock);
+                    locked = std::move(next);
+                }, keys);
+
+        RcuHashTable<string, int> rcu(2 * numKeys, hashFunc);
+        rcu.rebuild(fill);
+        double rcuRate = measureReadScaling(readers,
+                [&] {
+                    return [reader = std::make_shared<RcuHashTable<string, int>::Reader>(rcu.register_reader())]
+                            (const std::string& key) { return reader->getValue(key).has_value(); };
+                },
+                [&] { rcu.rebuild(fill); }, keys);
+
+        cout << readers << "; " << lockedRate << "; " << rcuRate << "\n";
+    }
+}
+
+void runFilterBenchmark() {
+    const size_t numKeys = 500000;
+    const size_t numLookups = 5000000;
+    auto keys = generateDeterministicKeys(numKeys);
+    std::vector<std::string> absent;
+    for (size_t i = 0; i < numKeys; i++)
+        absent.push_back("miss_" + std::to_string(i));
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    OpenAddrHashTable<string, int> plain(2 * numKeys, hashFunc);
+    OpenAddrHashTable<string, int> filtered(2 * numKeys, hashFunc);
+    filtered.enable_filter();
+    for (size_t i = 0; i < numKeys; i++) {
+        plain.insert(keys[i], static_cast<int>(i));
+        filtered.insert(keys[i], static_cast<int>(i));
+    }
+
+    cout << "Keys; Hits_per_sec_OA; Hits_per_sec_OA_filter; Misses_per_sec_OA; Misses_per_sec_OA_filter\n";
+    cout << numKeys << "; " << measureLookups(plain, keys, numLookups) << "; "
+         << measureLookups(filtered, keys, numLookups) << "; "
+         << measureLookups(plain, absent, numLookups, false) << "; "
+         << measureLookups(filtered, absent, numLookups, false) << "\n";
+}
+
+void runCacheBenchmark() {
+    const size_t universe = 200000;
+    const size_t numRequests = 2000000;
+    auto keys = generateDeterministicKeys(universe);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    cout << "Max_entries; Requests; Hit_rate; Evictions; Requests_per_sec\n";
+    for (size_t maxEntries : { universe / 100, universe / 10, universe / 2 }) {
+        OpenAddrHashTable<string, int> cache(4 * maxEntries, hashFunc);
+        cache.set_cache_limits({ .max_entries = maxEntries, .max_bytes = 0, .entry_bytes = {} });
+
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < numRequests; i++) {
+            // skewed toward low indices
+            size_t index = static_cast<size_t>(universe * pow((double) rand() / RAND_MAX, 4)) % universe;
+            if (cache.getValue(keys[index]) == nullptr)
+                cache.insert(keys[index], static_cast<int>(index));
+        }
+        auto stop = chrono::high_resolution_clock::now();
+
+        CacheStats stats = cache.cache_stats();
+        double seconds = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e9;
+        cout << maxEntries << "; " << numRequests << "; "
+             << (double) stats.hits / (stats.hits + stats.misses) << "; "
+             << stats.evictions << "; " << numRequests / seconds << "\n";
+    }
+}
+
+void runTtlBenchmark() {
+    const size_t numKeys = 200000;
+    const size_t budget = 1000;
+    auto keys = generateDeterministicKeys(numKeys);
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    // baseline: expiry tracked outside the table, expired keys removed one by one
+    OpenAddrHashTable<string, int> plain(16, hashFunc);
+    for (size_t i = 0; i < numKeys; i++)
+        plain.insert(keys[i], static_cast<int>(i));
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < numKeys; i += 2)
+        plain.remove(keys[i]);
+    auto stop = chrono::high_resolution_clock::now();
+    double plainMs = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e3;
+
+    OpenAddrHashTable<string, int> sessions(16, hashFunc);
+    sessions.enable_expiry(chrono::milliseconds(1));
+    for (size_t i = 0; i < numKeys; i++)
+        sessions.insert(keys[i], static_cast<int>(i), i % 2 == 0 ? chrono::milliseconds(20) : chrono::hours(1));
+    this_thread::sleep_for(chrono::milliseconds(50));
+
+    size_t expired = 0;
+    size_t ticks = 0;
+    double worstTickMs = 0;
+    start = chrono::high_resolution_clock::now();
+    while (true) {
+        auto tickStart = chrono::high_resolution_clock::now();
+        size_t removed = sessions.expire(budget);
+        auto tickStop = chrono::high_resolution_clock::now();
+        worstTickMs = max(worstTickMs, chrono::duration_cast<chrono::microseconds>(tickStop - tickStart).count() / 1e3);
+        if (removed == 0) break;
+        expired += removed;
+        ticks++;
+    }
+    stop = chrono::high_resolution_clock::now();
+    double wheelMs = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e3;
+
+    cout << "Keys; Expired; Remove_loop_ms; Wheel_expire_ms; Ticks; Worst_tick_ms\n";
+    cout << numKeys << "; " << expired << "; " << plainMs << "; " << wheelMs << "; "
+         << ticks << "; " << worstTickMs << "\n";
+}
+
+// a compile-time key set: the build runs in the compiler and lookups fold to constants
+static constexpr std::pair<std::string_view, int> HTTP_METHODS[] = {
+    { "GET", 1 }, { "HEAD", 2 }, { "POST", 3 }, { "PUT", 4 }, { "DELETE", 5 },
+    { "CONNECT", 6 }, { "OPTIONS", 7 }, { "TRACE", 8 }, { "PATCH", 9 }
+};
+static constexpr StaticPerfectHashMap<int, 9> httpMethods(HTTP_METHODS);
+static_assert(*httpMethods.find("PATCH") == 9 && !httpMethods.contains("FETCH"));
+
+void runPerfectHashBenchmark() {
+    const size_t numLookups = 5000000;
+    vector<size_t> sizes = { 1000, 100000, 1000000 };
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    cout << "Keys; Build_ms_PH; Hits_per_sec_OA; Hits_per_sec_PH; Misses_per_sec_OA; Misses_per_sec_PH\n";
+    for (size_t numKeys : sizes) {
+        auto keys = generateDeterministicKeys(numKeys);
+        std::vector<std::string> absent;
+        std::vector<std::pair<std::string, int>> entries;
+        for (size_t i = 0; i < numKeys; i++) {
+            absent.push_back("miss_" + std::to_string(i));
+            entries.push_back({ keys[i], static_cast<int>(i) });
+        }
+
+        OpenAddrHashTable<string, int> open(2 * numKeys, hashFunc);
+        for (const auto& [key, value] : entries)
+            open.insert(key, value);
+
+        auto start = chrono::high_resolution_clock::now();
+        PerfectHashTable<string, int> perfect(entries, hashFunc);
+        auto stop = chrono::high_resolution_clock::now();
+        double buildMs = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e3;
+
+        cout << numKeys << "; " << buildMs << "; "
+             << measureLookups(open, keys, numLookups) << "; "
+             << measureLookups(perfect, keys, numLookups) << "; "
+             << measureLookups(open, absent, numLookups, false) << "; "
+             << measureLookups(perfect, absent, numLookups, false) << "\n";
+    }
+
+    // the same key set seeded by every hasher; one that maps two keys to the same value is rejected
+    const size_t numKeys = 100000;
+    auto keys = generateDeterministicKeys(numKeys);
+    std::vector<std::pair<std::string, int>> entries;
+    for (size_t i = 0; i < numKeys; i++)
+        entries.push_back({ keys[i], static_cast<int>(i) });
+    cout << "\nFunction; Keys; Build_ms_PH\n";
+    for (auto& [name, seedHash] : makeHashFunctions()) {
+        cout << name << "; " << numKeys << "; ";
+        try {
+            auto start = chrono::high_resolution_clock::now();
+            PerfectHashTable<string, int> perfect(entries, seedHash);
+            auto stop = chrono::high_resolution_clock::now();
+            cout << chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e3 << "\n";
+        } catch (const std::invalid_argument&) {
+            cout << "rejected\n";
+        }
+    }
+}
+
+void runFreezeBenchmark() {
+    const size_t numLookups = 5000000;
+    vector<size_t> sizes = { 1000, 100000, 1000000 };
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    cout << "Keys; Freeze_ms; Hits_per_sec_OA; Hits_per_sec_Ch; Hits_per_sec_Frozen; "
+         << "Misses_per_sec_OA; Misses_per_sec_Ch; Misses_per_sec_Frozen\n";
+    for (size_t numKeys : sizes) {
+        auto keys = generateDeterministicKeys(numKeys);
+        std::vector<std::string> absent;
+        for (size_t i = 0; i < numKeys; i++)
+            absent.push_back("miss_" + std::to_string(i));
+
+        OpenAddrHashTable<string, int> open(16, hashFunc);
+        ChainingHashTable<string, int> chaining(16, hashFunc);
+        for (size_t i = 0; i < numKeys; i++) {
+            open.insert(keys[i], static_cast<int>(i));
+            chaining.insert(keys[i], static_cast<int>(i));
+        }
+
+        auto start = chrono::high_resolution_clock::now();
+        FrozenHashTable<string, int> frozen = open.freeze();
+        auto stop = chrono::high_resolution_clock::now();
+        double freezeMs = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1e3;
+
+        cout << numKeys << "; " << freezeMs << "; "
+             << measureLookups(open, keys, numLookups) << "; "
+             << measureLookups(chaining, keys, numLookups) << "; "
+             << measureLookups(frozen, keys, numLookups) << "; "
+             << measureLookups(open, absent, numLookups, false) << "; "
+             << measureLookups(chaining, absent, numLookups, false) << "; "
+             << measureLookups(frozen, absent, numLookups, false) << "\n";
+    }
+}
+
+void runFastModBenchmark() {
+    const size_t numReductions = 20000000;
+    vector<size_t> capacities = { next_prime(1000), next_prime(1000000), next_prime(1000000000) };
+    vector<uint64_t> hashes(4096);
+    for (size_t i = 0; i < hashes.size(); i++)
+        hashes[i] = IntegerMixHash()(i);
+
+    cout << "Capacity; Mod_per_sec; FastMod_per_sec\n";
+    for (size_t capacity : capacities) {
+        // the divisor is hidden from the optimizer so `%` stays a real division
+        volatile size_t opaque = capacity;
+        size_t divisor = opaque;
+        FastMod fastMod(divisor);
+        size_t sum = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < numReductions; i++)
+            sum += hashes[i & 4095] % divisor;
+        auto stop = chrono::high_resolution_clock::now();
+        double modSeconds = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e9;
+
+        start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < numReductions; i++)
+            sum -= fastMod(hashes[i & 4095]);
+        stop = chrono::high_resolution_clock::now();
+        double fastSeconds = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1e9;
+        if (sum != 0)
+            cerr << "fastmod benchmark: results differ from %\n";
+
+        cout << capacity << "; " << numReductions / modSeconds << "; " << numReductions / fastSeconds << "\n";
+    }
+}
+
+enum class Workload { HIT, MISS, UPDATE, MIXED };
+
+// runs `ops` operations of one workload against a table holding `keys` and returns the mean
+// nanoseconds per operation; the operation sequence is drawn before the clock starts. Hardware
+// counters, when given, cover exactly the timed loop.
+template<typename Table>
+double measureWorkload(Table& table, Workload workload, const std::vector<std::string>& keys,
+                       const std::vector<std::string>& absent, size_t ops, PerfCounters* counters = nullptr) {
+    enum Kind : uint8_t { GET_HIT, GET_MISS, UPDATE };
+    std::mt19937 rng(42);
+    std::vector<std::pair<Kind, size_t>> sequence;
+    size_t expectedHits = 0;
+    for (size_t i = 0; i < ops; i++) {
+        Kind kind = GET_HIT;
+        if (workload == Workload::MISS) kind = GET_MISS;
+        if (workload == Workload::UPDATE) kind = UPDATE;
+        // lookups dominate real traffic: 90% hits, 5% misses, 5% updates
+        if (workload == Workload::MIXED) {
+            size_t roll = rng() % 100;
+            kind = roll < 90 ? GET_HIT : roll < 95 ? GET_MISS : UPDATE;
+        }
+        if (kind == GET_HIT) expectedHits++;
+        sequence.push_back({ kind, rng() % (kind == GET_MISS ? absent.size() : keys.size()) });
+    }
+
+    size_t found = 0;
+    if (counters) counters->start();
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < ops; i++) {
+        auto [kind, index] = sequence[i];
+        if (kind == GET_HIT)
+            found += table.getValue(keys[index]) != nullptr;
+        else if (kind == GET_MISS)
+            found += table.getValue(absent[index]) != nullptr;
+        else
+            table.insert(keys[index], static_cast<int>(i));
+    }
+    auto stop = chrono::high_resolution_clock::now();
+    if (counters) counters->stop();
+    if (found != expectedHits)
+        cerr << "workload benchmark: " << found << " keys found, expected " << expectedHits << "\n";
+    return chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(ops);
+}
+
+// with counters, each row also gets every hardware event divided by the number of operations
+void runLookupBenchmark(bool json, PerfCounters* counters) {
+    const size_t numOps = 100000;
+    auto hashFunctions = makeHashFunctions();
+    float percentages[] = { 0.10, 0.25, 0.33, 0.50, 0.75, 1.00 };
+    const std::vector<size_t> sizes = { 1000, 10000 };
+    const std::pair<Workload, std::string> workloads[] = {
+        { Workload::HIT, "hit" }, { Workload::MISS, "miss" }, { Workload::UPDATE, "update" }, { Workload::MIXED, "mixed" }
+    };
+
+    vector<string> columns = { "Percentage", "Initial_size", "Function", "Table", "Workload", "Ns_per_op" };
+    if (counters) {
+        for (const char* event : PerfCounters::NAMES)
+            columns.push_back(string(event) + "_per_op");
+    }
+    ReportWriter report(columns, json);
+    for (auto percentage : percentages) {
+        for (auto& [name, hashFunc] : hashFunctions) {
+            for (auto size : sizes) {
+                size_t numKeys = static_cast<size_t>(size * percentage);
+                auto keys = generateDeterministicKeys(numKeys);
+                std::vector<std::string> absent;
+                for (size_t i = 0; i < numKeys; i++)
+                    absent.push_back("miss_" + std::to_string(i));
+
+                ChainingHashTable<string, int> tableCh(size, hashFunc);
+                OpenAddrHashTable<string, int> tableOA(size, hashFunc);
+                for (size_t i = 0; i < numKeys; i++) {
+                    tableCh.insert(keys[i], static_cast<int>(i));
+                    tableOA.insert(keys[i], static_cast<int>(i));
+                }
+
+                auto measure = [&](auto& table, const string& tableName, Workload workload, const string& workloadName) {
+                    vector<string> row = { report_number(percentage), to_string(size), name, tableName, workloadName,
+                                           report_number(measureWorkload(table, workload, keys, absent, numOps, counters)) };
+                    for (int e = 0; counters && e < PerfCounters::NUM_EVENTS; e++) {
+                        auto event = static_cast<PerfCounters::Event>(e);
+                        row.push_back(counters->has(event) ? report_number(counters->count(event) / numOps) : "n/a");
+                    }
+                    report.row(row);
+                };
+                for (auto& [workload, workloadName] : workloads) {
+                    measure(tableCh, "Ch", workload, workloadName);
+                    measure(tableOA, "OA", workload, workloadName);
+                }
+            }
+        }
+    }
+}
+
+// times every operation of a table's life individually: inserts from a small initial capacity
+// (so resizes show up in the tail), lookups that hit and miss, then removal of every key
+template<typename Table>
+void measureLatencies(ReportWriter& report, const std::string& hasherName, const std::string& tableName,
+                      Table& table, const LatencyTimer& timer, const std::vector<std::string>& keys,
+                      const std::vector<std::string>& absent) {
+    LatencyHistogram insert, hit, miss, remove;
+    for (size_t i = 0; i < keys.size(); i++)
+        timer.time(insert, [&] { table.insert(keys[i], static_cast<int>(i)); });
+    for (const auto& key : keys)
+        timer.time(hit, [&] { table.getValue(key); });
+    for (const auto& key : absent)
+        timer.time(miss, [&] { table.getValue(key); });
+    for (const auto& key : keys)
+        timer.time(remove, [&] { table.remove(key); });
+
+    const std::pair<const char*, LatencyHistogram*> operations[] = {
+        { "insert", &insert }, { "get_hit", &hit }, { "get_miss", &miss }, { "remove", &remove }
+    };
+    for (auto& [operation, histogram] : operations) {
+        report.row({ hasherName, tableName, operation, to_string(histogram->count()),
+                     report_number(histogram->mean()),
+                     to_string(histogram->percentile(0.5)), to_string(histogram->percentile(0.9)),
+                     to_string(histogram->percentile(0.99)), to_string(histogram->percentile(0.999)),
+                     to_string(histogram->max()) });
+    }
+}
+
+void runLatencyBenchmark(bool json) {
+    const size_t numKeys = 20000;
+    auto hashFunctions = makeHashFunctions();
+    auto keys = generateDeterministicKeys(numKeys);
+    std::vector<std::string> absent;
+    for (size_t i = 0; i < numKeys; i++)
+        absent.push_back("miss_" + std::to_string(i));
+
+    LatencyTimer timer;
+    cerr << "clock overhead subtracted: " << timer.overhead() << " ns\n";
+    ReportWriter report({ "Function", "Table", "Operation", "Count", "Mean_ns", "P50_ns", "P90_ns",
+                          "P99_ns", "P99_9_ns", "Max_ns" }, json);
+    for (auto& [name, hashFunc] : hashFunctions) {
+        ChainingHashTable<string, int> tableCh(16, hashFunc);
+        OpenAddrHashTable<string, int> tableOA(16, hashFunc);
+        CuckooHashTable<string, int> tableCu(16, hashFunc);
+        measureLatencies(report, name, "Ch", tableCh, timer, keys, absent);
+        measureLatencies(report, name, "OA", tableOA, timer, keys, absent);
+        measureLatencies(report, name, "Cu", tableCu, timer, keys, absent);
+    }
+}
+
+void reportMemory(ReportWriter& report, const std::string& tableName, size_t keyLength, const MemoryUsage& usage) {
+    report.row({ tableName, to_string(keyLength), to_string(usage.entries), to_string(usage.slots),
+                 report_number(usage.load_factor()), to_string(usage.arrays), to_string(usage.nodes),
+                 to_string(usage.key_storage), to_string(usage.value_storage), to_string(usage.other),
+                 report_number(usage.bytes_per_entry()) });
+}
+
+// fills each table key by key and samples its footprint every 25% of growth, so every point of
+// the resize cycle shows up; keys shorter than 16 characters fit std::string's inline buffer
+void runMemoryBenchmark(bool json) {
+    const size_t maxKeys = 200000;
+    const size_t keyLengths[] = { 8, 16, 32, 64 };
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    ReportWriter report({ "Table", "Key_length", "Entries", "Slots", "Load_factor", "Array_bytes", "Node_bytes",
+                          "Key_bytes", "Value_bytes", "Other_bytes", "Bytes_per_entry" }, json);
+    for (size_t keyLength : keyLengths) {
+        ChainingHashTable<string, int> tableCh(16, hashFunc);
+        OpenAddrHashTable<string, int> tableOA(16, hashFunc);
+        SplitOpenAddrHashTable<string, int> tableSplit(16, hashFunc);
+        CuckooHashTable<string, int> tableCu(16, hashFunc);
+        HopscotchHashTable<string, int> tableHop(16, hashFunc);
+
+        size_t inserted = 0;
+        for (size_t sample = 1000; sample <= maxKeys; sample += sample / 4) {
+            for (; inserted < sample; inserted++) {
+                std::string key = std::to_string(inserted);
+                key.insert(0, keyLength - key.size(), 'k');
+                int value = static_cast<int>(inserted);
+                tableCh.insert(key, value);
+                tableOA.insert(key, value);
+                tableSplit.insert(key, value);
+                tableCu.insert(key, value);
+                tableHop.insert(key, value);
+            }
+            reportMemory(report, "Ch", keyLength, tableCh.memory_usage());
+            reportMemory(report, "OA", keyLength, tableOA.memory_usage());
+            reportMemory(report, "Split", keyLength, tableSplit.memory_usage());
+            reportMemory(report, "Cu", keyLength, tableCu.memory_usage());
+            reportMemory(report, "Hop", keyLength, tableHop.memory_usage());
+            reportMemory(report, "Frozen", keyLength, tableOA.freeze().memory_usage());
+        }
+    }
+}
+
+// one timed batch per operation on a fresh table: inserting every key, looking each one up,
+// looking up as many absent keys, then removing every key; returns ns per operation for each
+template<typename Table>
+std::array<double, 4> measureOperationBatches(Table& table, const std::vector<std::string>& keys,
+                                              const std::vector<std::string>& absent) {
+    std::array<double, 4> result;
+    size_t found = 0;
+    auto timeBatch = [&](auto&& body) {
+        auto start = chrono::high_resolution_clock::now();
+        body();
+        auto stop = chrono::high_resolution_clock::now();
+        return chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(keys.size());
+    };
+    result[0] = timeBatch([&] { for (size_t i = 0; i < keys.size(); i++) table.insert(keys[i], static_cast<int>(i)); });
+    result[1] = timeBatch([&] { for (const auto& key : keys) found += table.getValue(key) != nullptr; });
+    result[2] = timeBatch([&] { for (const auto& key : absent) found += table.getValue(key) != nullptr; });
+    result[3] = timeBatch([&] { for (const auto& key : keys) table.remove(key); });
+    if (found != keys.size())
+        cerr << "regression benchmark: " << found << " keys found, expected " << keys.size() << "\n";
+    return result;
+}
+
+// Runs the sweep grid (percentage x initial size x hasher x table x operation) SAMPLES times and
+// compares the means against the baseline file with Welch's t-test. A configuration counts as
+// changed only when the difference is significant at 1% and at least MIN_CHANGE of the baseline.
+// Without a baseline, or with `update`, the new results become the baseline. Returns the number
+// of regressions.
+size_t runRegressionCheck(const std::string& baselinePath, bool update, bool json) {
+    const size_t SAMPLES = 7;
+    const double MIN_CHANGE = 0.05;
+    const char* operations[] = { "insert", "get_hit", "get_miss", "remove" };
+    auto hashFunctions = makeHashFunctions();
+    float percentages[] = { 0.10, 0.25, 0.33, 0.50, 0.75, 1.00 };
+    const std::vector<size_t> sizes = { 1000, 10000 };
+
+    // samples are interleaved across configurations so slow drift on the host hits all of them
+    std::vector<std::vector<std::string>> configs;
+    std::map<std::vector<std::string>, std::vector<double>> samples;
+    for (size_t round = 0; round < SAMPLES; round++) {
+        for (auto percentage : percentages) {
+            for (auto& [name, hashFunc] : hashFunctions) {
+                for (auto size : sizes) {
+                    size_t numKeys = static_cast<size_t>(size * percentage);
+                    auto keys = generateDeterministicKeys(numKeys);
+                    std::vector<std::string> absent;
+                    for (size_t i = 0; i < numKeys; i++)
+                        absent.push_back("miss_" + std::to_string(i));
+
+                    auto record = [&](const string& tableName, const std::array<double, 4>& nsPerOp) {
+                        for (size_t op = 0; op < nsPerOp.size(); op++) {
+                            std::vector<std::string> config = { report_number(percentage), to_string(size), name,
+                                                                tableName, operations[op] };
+                            if (round == 0) configs.push_back(config);
+                            samples[config].push_back(nsPerOp[op]);
+                        }
+                    };
+                    ChainingHashTable<string, int> tableCh(size, hashFunc);
+                    OpenAddrHashTable<string, int> tableOA(size, hashFunc);
+                    record("Ch", measureOperationBatches(tableCh, keys, absent));
+                    record("OA", measureOperationBatches(tableOA, keys, absent));
+                }
+            }
+        }
+    }
+
+    const std::vector<std::string> keyColumns = { "Percentage", "Initial_size", "Function", "Table", "Operation" };
+    std::map<std::vector<std::string>, SampleStats> baseline;
+    std::ifstream baselineFile(baselinePath);
+    if (baselineFile) {
+        for (auto& row : read_report(baselineFile)) {
+            std::vector<std::string> config;
+            for (const auto& column : keyColumns)
+                config.push_back(row[column]);
+            baseline[config] = { stod(row["Mean_ns"]), stod(row["Stddev_ns"]), stoul(row["Samples"]) };
+        }
+        baselineFile.close();
+    }
+
+    size_t regressions = 0, improvements = 0;
+    {
+        vector<string> columns = keyColumns;
+        columns.insert(columns.end(), { "Baseline_ns", "Current_ns", "Change_pct", "T", "Verdict" });
+        ReportWriter report(columns, json);
+        for (const auto& config : configs) {
+            SampleStats current = SampleStats::of(samples[config]);
+            std::vector<std::string> row = config;
+            auto it = baseline.find(config);
+            if (it == baseline.end()) {
+                row.insert(row.end(), { "n/a", report_number(current.mean), "n/a", "n/a", "new" });
+                report.row(row);
+                continue;
+            }
+            auto [t, significant] = welch_test(it->second, current);
+            double change = (current.mean - it->second.mean) / it->second.mean;
+            std::string verdict = "unchanged";
+            if (significant && std::fabs(change) >= MIN_CHANGE) {
+                verdict = change > 0 ? "regression" : "improvement";
+                (change > 0 ? regressions : improvements)++;
             }
+            row.insert(row.end(), { report_number(it->second.mean), report_number(current.mean),
+                                    report_number(change * 100), report_number(t), verdict });
+            report.row(row);
+        }
+    }
+    cerr << regressions << " regressions, " << improvements << " improvements against "
+         << (baseline.empty() ? "no baseline" : baselinePath) << "\n";
+
+    if (baseline.empty() || update) {
+        std::ofstream out(baselinePath);
+        vector<string> columns = keyColumns;
+        columns.insert(columns.end(), { "Samples", "Mean_ns", "Stddev_ns" });
+        ReportWriter writer(columns, true, out);
+        for (const auto& config : configs) {
+            SampleStats stats = SampleStats::of(samples[config]);
+            std::vector<std::string> row = config;
+            row.insert(row.end(), { to_string(stats.count), report_number(stats.mean), report_number(stats.stddev) });
+            writer.row(row);
         }
+        cerr << "baseline written to " << baselinePath << "\n";
     }
+    return regressions;
+}
+
+// per-key insert/getValue against insert_many/get_many with the DJB2 batch hasher, and the hashing
+// alone, scalar against hash_many; all in nanoseconds per key
+void runBatchBenchmark(bool json) {
+    const std::vector<size_t> sizes = { 10000, 1000000 };
+    const std::vector<size_t> keyLengths = { 8, 16, 32 };
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    ReportWriter report({ "Keys", "Key_length", "Table", "Operation", "Per_key_ns", "Batch_ns" }, json);
+    for (size_t numKeys : sizes) {
+        for (size_t keyLength : keyLengths) {
+            // decimal index padded to length, so even the shortest keys stay distinct
+            std::vector<std::string> keys;
+            for (size_t i = 0; i < numKeys; i++) {
+                keys.push_back(to_string(i));
+                keys.back().resize(keyLength, '#');
+            }
+            std::vector<int> values(numKeys);
+            for (size_t i = 0; i < numKeys; i++) values[i] = static_cast<int>(i);
+            std::vector<size_t> hashes(numKeys);
+            std::vector<int*> found(numKeys);
+            size_t repeats = std::max<size_t>(1, 4000000 / numKeys);
+
+            auto nsPerKey = [&](auto&& run) {
+                auto start = chrono::high_resolution_clock::now();
+                for (size_t r = 0; r < repeats; r++) run();
+                auto stop = chrono::high_resolution_clock::now();
+                return chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(repeats * numKeys);
+            };
+            auto row = [&](const string& table, const string& operation, double perKey, double batch) {
+                report.row({ to_string(numKeys), to_string(keyLength), table, operation,
+                             report_number(perKey), report_number(batch) });
+            };
+
+            row("-", "hash", nsPerKey([&] { djb2_many_scalar(keys, hashes); }),
+                nsPerKey([&] { hash_many(keys, hashes); }));
+
+            auto measure = [&](auto makeTable, const string& tableName) {
+                double insertOne = nsPerKey([&] {
+                    auto table = makeTable();
+                    for (size_t i = 0; i < numKeys; i++) table->insert(keys[i], values[i]);
+                });
+                double insertMany = nsPerKey([&] {
+                    auto table = makeTable();
+                    table->insert_many(keys, values);
+                });
+                row(tableName, "insert", insertOne, insertMany);
+
+                auto table = makeTable();
+                table->insert_many(keys, values);
+                double getOne = nsPerKey([&] {
+                    for (size_t i = 0; i < numKeys; i++) found[i] = table->getValue(keys[i]);
+                });
+                double getMany = nsPerKey([&] { table->get_many(keys, found); });
+                row(tableName, "get", getOne, getMany);
+            };
+            measure([&] {
+                auto table = std::make_unique<ChainingHashTable<string, int>>(numKeys * 2, hashFunc);
+                table->set_batch_hasher(hash_many);
+                return table;
+            }, "Ch");
+            measure([&] {
+                auto table = std::make_unique<OpenAddrHashTable<string, int>>(numKeys * 2, hashFunc);
+                table->set_batch_hasher(hash_many);
+                return table;
+            }, "OA");
+        }
+    }
+}
+
+// every kernel tier the CPU supports in turn: batch DJB2 hashing, and Split lookups, whose probe
+// loop compares a group of control bytes per step
+void runDispatchBenchmark(bool json) {
+    const size_t numLookups = 1000000;
+    const std::vector<size_t> sizes = { 10000, 200000 };
+    auto hashFunctions = makeHashFunctions();
+    CpuLevel detected = cpu_level();
+
+    ReportWriter report({ "Level", "Function", "Keys", "Hash_many_ns_per_key", "Hits_per_sec_Split",
+                          "Misses_per_sec_Split" }, json);
+    for (CpuLevel level : { CpuLevel::SCALAR, CpuLevel::SSE42, CpuLevel::AVX2, CpuLevel::AVX512 }) {
+        if (level > detected) break;
+        set_cpu_level(level);
+        for (size_t numKeys : sizes) {
+            auto keys = generateDeterministicKeys(numKeys);
+            std::vector<std::string> absent;
+            for (size_t i = 0; i < numKeys; i++)
+                absent.push_back("miss_" + std::to_string(i));
+
+            std::vector<size_t> hashes(numKeys);
+            size_t repeats = std::max<size_t>(1, 4000000 / numKeys);
+            auto start = chrono::high_resolution_clock::now();
+            for (size_t r = 0; r < repeats; r++) hash_many(keys, hashes);
+            auto stop = chrono::high_resolution_clock::now();
+            double hashNs = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(repeats * numKeys);
+
+            for (auto& [name, hashFunc] : hashFunctions) {
+                // Additive packs the keys into one long cluster, where group probing pays off most,
+                // but is too slow to probe past 10000 keys; Fibonacci and Multiplicative spend
+                // their time in the hasher rather than the probe loop
+                if (name == "FibonacciHash" || name == "MultiplicativeHash") continue;
+                if (name == "AdditiveHash" && numKeys > 10000) continue;
+                size_t lookups = name == "AdditiveHash" ? numLookups / 100 : numLookups;
+                SplitOpenAddrHashTable<string, int> table(16, hashFunc);
+                for (size_t i = 0; i < numKeys; i++)
+                    table.insert(keys[i], static_cast<int>(i));
+                report.row({ cpu_level_name(level), name, to_string(numKeys), report_number(hashNs),
+                             report_number(measureLookups(table, keys, lookups)),
+                             report_number(measureLookups(table, absent, lookups, false)) });
+            }
+        }
+    }
+    set_cpu_level(detected);
+}
+
+// raw cost of each hasher per key length, and how evenly the low 16 bits of its output spread
+// 65536 keys over as many buckets, which is what a power-of-two table would index by; random
+// hashes leave 1/e, about 36.8%, of the buckets empty
+void runHasherBenchmark(bool json) {
+    const size_t numKeys = 65536;
+    const size_t numHashes = 4000000;
+    const std::vector<size_t> keyLengths = { 8, 16, 32, 64 };
+
+    ReportWriter report({ "Function", "Key_length", "Ns_per_hash", "Empty_buckets_pct", "Max_bucket" }, json);
+    for (auto& [name, hashFunc] : makeHashFunctions()) {
+        for (size_t keyLength : keyLengths) {
+            std::vector<std::string> keys;
+            for (size_t i = 0; i < numKeys; i++) {
+                keys.push_back(to_string(i));
+                keys.back().resize(keyLength, '#');
+            }
 
+            size_t sum = 0;
+            auto start = chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < numHashes; i++)
+                sum += hashFunc(keys[i % numKeys], numKeys);
+            auto stop = chrono::high_resolution_clock::now();
+            double ns = chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(numHashes);
+            // the hashes must be used or the loop could be dropped
+            volatile size_t sink = sum;
+            (void)sink;
+
+            std::vector<size_t> buckets(numKeys, 0);
+            for (const std::string& key : keys)
+                buckets[hashFunc(key, numKeys) & (numKeys - 1)]++;
+            size_t empty = std::count(buckets.begin(), buckets.end(), 0);
+            report.row({ name, to_string(keyLength), report_number(ns), report_number(100.0 * empty / numKeys),
+                         to_string(*std::max_element(buckets.begin(), buckets.end())) });
+        }
+    }
+}
+
+// a request handler's table: fill with a request's keys, look each up, then either drop the table
+// and construct a new one for the next request or clear() it and keep its capacity
+void runReuseBenchmark(bool json) {
+    const size_t totalKeys = 2000000;
+    const std::vector<size_t> requestSizes = { 16, 256, 4096 };
+    auto hashFunc = [](const std::string& key, size_t cap) { return DJB2Hash()(key, cap); };
+
+    ReportWriter report({ "Keys_per_request", "Table", "Fresh_ns_per_request", "Clear_ns_per_request" }, json);
+    for (size_t requestSize : requestSizes) {
+        auto keys = generateDeterministicKeys(requestSize);
+        size_t requests = totalKeys / requestSize;
+
+        auto serve = [&](auto& table) {
+            for (size_t i = 0; i < requestSize; i++)
+                table.insert(keys[i], static_cast<int>(i));
+            size_t found = 0;
+            for (size_t i = 0; i < requestSize; i++)
+                found += table.getValue(keys[i]) != nullptr;
+            if (found != requestSize)
+                cerr << "reuse benchmark: " << requestSize - found << " keys not found\n";
+        };
+        auto nsPerRequest = [&](auto&& run) {
+            auto start = chrono::high_resolution_clock::now();
+            run();
+            auto stop = chrono::high_resolution_clock::now();
+            return chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / static_cast<double>(requests);
+        };
+        auto measure = [&](auto makeTable, const string& tableName) {
+            double fresh = nsPerRequest([&] {
+                for (size_t r = 0; r < requests; r++) {
+                    auto table = makeTable();
+                    serve(*table);
+                }
+            });
+            double cleared = nsPerRequest([&] {
+                auto table = makeTable();
+                for (size_t r = 0; r < requests; r++) {
+                    serve(*table);
+                    table->clear();
+                }
+            });
+            report.row({ to_string(requestSize), tableName, report_number(fresh), report_number(cleared) });
+        };
+        // sized for the request up front, as a handler that knows its request would
+        measure([&] { return std::make_unique<ChainingHashTable<string, int>>(requestSize * 2, hashFunc); }, "Ch");
+        measure([&] { return std::make_unique<OpenAddrHashTable<string, int>>(requestSize * 2, hashFunc); }, "OA");
+        measure([&] { return std::make_unique<SplitOpenAddrHashTable<string, int>>(requestSize * 2, hashFunc); }, "Split");
+    }
+}
+
+// correctness checks registered with ctest; every failure is reported and counted
+int runSelfChecks() {
+    int failures = 0;
+    auto check = [&](bool ok, const string& what) {
+        if (!ok) {
+            cerr << "check failed: " << what << "\n";
+            failures++;
+        }
+    };
+
+    // AdditiveHash gives most keys one of a few hundred homes, far more than a neighborhood holds,
+    // so nearly all of them go to the overflow store; the table must still take every one
+    {
+        const size_t numKeys = 20000;
+        auto keys = generateDeterministicKeys(numKeys);
+        HopscotchHashTable<string, int> table(16, [](const std::string& key, size_t cap) { return AdditiveHash()(key, cap); });
+        try {
+            for (size_t i = 0; i < numKeys; i++)
+                table.insert(keys[i], static_cast<int>(i));
+            size_t found = 0;
+            for (size_t i = 0; i < numKeys; i++) {
+                const int* value = table.getValue(keys[i]);
+                found += value && *value == static_cast<int>(i);
+            }
+            check(found == numKeys, "hopscotch with AdditiveHash lost " + to_string(numKeys - found) + " keys");
+            for (size_t i = 0; i < numKeys; i += 2)
+                table.remove(keys[i]);
+            size_t left = 0;
+            for (size_t i = 0; i < numKeys; i++)
+                left += table.getValue(keys[i]) != nullptr;
+            check(left == numKeys / 2, "hopscotch with AdditiveHash kept " + to_string(left) + " keys after removing half");
+        } catch (const std::exception& e) {
+            check(false, string("hopscotch with AdditiveHash threw: ") + e.what());
+        }
+    }
+
+    // every key hashes to bucket 0, so only the alternates tell keys apart; a key whose alternate
+    // came out equal to its primary would have bucket 0 and the stash as its only places
+    {
+        const size_t numKeys = 2000;
+        auto keys = generateDeterministicKeys(numKeys);
+        CuckooHashTable<string, int> table(16, [](const std::string&, size_t) { return size_t(0); });
+        for (size_t i = 0; i < numKeys; i++)
+            table.insert(keys[i], static_cast<int>(i));
+        size_t found = 0;
+        for (size_t i = 0; i < numKeys; i++) {
+            const int* value = table.getValue(keys[i]);
+            found += value && *value == static_cast<int>(i);
+        }
+        check(found == numKeys, "cuckoo with one primary bucket lost " + to_string(numKeys - found) + " keys");
+        check(table.getValue("absent") == nullptr, "cuckoo with one primary bucket found an absent key");
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    srand((time(NULL)));
+
+    // --perf adds hardware counters to the modes that support them
+    bool perf = false;
+    vector<string> args;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--perf")
+            perf = true;
+        else
+            args.push_back(argv[i]);
+    }
+    string mode = args.size() > 0 ? args[0] : "sweep";
+    string format = args.size() > 1 ? args[1] : "csv";
+    if (mode == "sweep") {
+        runSweep();
+    } else if (mode == "hugepages") {
+        runHugePageBenchmark();
+    } else if (mode == "layout") {
+        runLayoutBenchmark();
+    } else if (mode == "intkeys") {
+        runIntegerKeyBenchmark();
+    } else if (mode == "density") {
+        runDensityBenchmark();
+    } else if (mode == "probing") {
+        runProbingBenchmark();
+    } else if (mode == "flooding") {
+        runFloodingBenchmark();
+    } else if (mode == "concurrent") {
+        runConcurrentBenchmark();
+    } else if (mode == "rcu") {
+        runRcuBenchmark();
+    } else if (mode == "filter") {
+        runFilterBenchmark();
+    } else if (mode == "cache") {
+        runCacheBenchmark();
+    } else if (mode == "ttl") {
+        runTtlBenchmark();
+    } else if (mode == "perfect") {
+        runPerfectHashBenchmark();
+    } else if (mode == "freeze") {
+        runFreezeBenchmark();
+    } else if (mode == "fastmod") {
+        runFastModBenchmark();
+    } else if (mode == "lookups") {
+        std::unique_ptr<PerfCounters> counters;
+        if (perf) {
+            counters = std::make_unique<PerfCounters>();
+            if (!counters->any())
+                cerr << "perf_event_open is not available here (check kernel.perf_event_paranoid); counters read n/a\n";
+        }
+        runLookupBenchmark(format == "json", counters.get());
+    } else if (mode == "latency") {
+        runLatencyBenchmark(format == "json");
+    } else if (mode == "memory") {
+        runMemoryBenchmark(format == "json");
+    } else if (mode == "batch") {
+        runBatchBenchmark(format == "json");
+    } else if (mode == "dispatch") {
+        runDispatchBenchmark(format == "json");
+    } else if (mode == "hashers") {
+        runHasherBenchmark(format == "json");
+    } else if (mode == "reuse") {
+        runReuseBenchmark(format == "json");
+    } else if (mode == "check") {
+        return runSelfChecks() > 0 ? 2 : 0;
+    } else if (mode == "regress") {
+        // P3 regress [baseline.json] [update] [csv|json]
+        string baselinePath = "baseline.json";
+        bool update = false, json = false;
+        for (size_t i = 1; i < args.size(); i++) {
+            if (args[i] == "update") update = true;
+            else if (args[i] == "json") json = true;
+            else if (args[i] != "csv") baselinePath = args[i];
+        }
+        return runRegressionCheck(baselinePath, update, json) > 0 ? 2 : 0;
+    } else {
+        cerr << "Unknown mode: " << mode << "\n"
+             << "Usage: " << argv[0] << " [sweep|hugepages|layout|intkeys|density|probing|flooding|concurrent|rcu|filter|cache|ttl|perfect|freeze|fastmod|lookups|latency|memory|batch|dispatch|hashers|reuse] [csv|json] [--perf]\n"
+             << "       " << argv[0] << " regress [baseline.json] [update] [csv|json]\n"
+             << "       " << argv[0] << " check\n";
+        return 1;
+    }
 
     return 0;
 }
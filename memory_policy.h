@@ -0,0 +1,119 @@
+#ifndef P3_MEMORY_POLICY_H
+#define P3_MEMORY_POLICY_H
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+enum class PageMode { DEFAULT, TRANSPARENT_HUGE, EXPLICIT_HUGE };
+enum class NumaMode { DEFAULT, INTERLEAVE, BIND };
+
+struct MemoryPolicy {
+    PageMode pages = PageMode::DEFAULT;
+    NumaMode numa = NumaMode::DEFAULT;
+    unsigned long node_mask = 0;   // nodes used by INTERLEAVE/BIND, 0 = all nodes
+
+    bool uses_mmap() const { return pages != PageMode::DEFAULT || numa != NumaMode::DEFAULT; }
+};
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+inline size_t round_to_huge_page(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+inline void apply_numa_policy(void* memory, size_t bytes, const MemoryPolicy& policy) {
+    if (policy.numa == NumaMode::DEFAULT) return;
+
+    // the kernel intersects the mask with the online memory nodes
+    unsigned long mask = policy.node_mask == 0 ? ~0UL : policy.node_mask;
+    int mode = policy.numa == NumaMode::INTERLEAVE ? MPOL_INTERLEAVE : MPOL_BIND;
+    // best effort: on single-node hosts or kernels without NUMA the call fails and the default policy stays
+    syscall(SYS_mbind, memory, bytes, mode, &mask, sizeof(mask) * 8, 0);
+}
+
+inline void* map_memory(size_t bytes, const MemoryPolicy& policy) {
+    size_t length = round_to_huge_page(bytes);
+    void* memory = MAP_FAILED;
+
+    if (policy.pages == PageMode::EXPLICIT_HUGE)
+        memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory == MAP_FAILED)
+        memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        throw std::bad_alloc();
+
+    if (policy.pages != PageMode::DEFAULT)
+        madvise(memory, length, MADV_HUGEPAGE);
+    apply_numa_policy(memory, length, policy);
+    return memory;
+}
+
+inline void unmap_memory(void* memory, size_t bytes) {
+    munmap(memory, round_to_huge_page(bytes));
+}
+
+template<typename T>
+T* allocate_slots(size_t count, const MemoryPolicy& policy) {
+    if (!policy.uses_mmap())
+        return new T[count];
+
+    T* slots = static_cast<T*>(map_memory(count * sizeof(T), policy));
+    for (size_t i = 0; i < count; i++)
+        new (&slots[i]) T();
+    return slots;
+}
+
+template<typename T>
+void release_slots(T* slots, size_t count, const MemoryPolicy& policy) {
+    if (!policy.uses_mmap()) {
+        delete[] slots;
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        slots[i].~T();
+    unmap_memory(slots, count * sizeof(T));
+}
+
+// bytes reserved by allocate_slots(count, policy); mapped arrays occupy whole huge pages
+template<typename T>
+size_t slot_bytes(size_t count, const MemoryPolicy& policy) {
+    return policy.uses_mmap() ? round_to_huge_page(count * sizeof(T)) : count * sizeof(T);
+}
+
+// Footprint reported by a table's memory_usage(), in bytes requested from the allocator (malloc
+// headers and rounding are not included). Slots and buckets are counted whether used or not.
+struct MemoryUsage {
+    size_t arrays = 0;          // slot and bucket arrays plus per-slot side arrays
+    size_t nodes = 0;           // per-entry allocations: list and tree nodes, overflow and stash storage
+    size_t key_storage = 0;     // heap buffers owned by keys, e.g. strings too long for the inline buffer
+    size_t value_storage = 0;   // heap buffers owned by values
+    size_t other = 0;           // filters, timers and similar side structures
+    size_t entries = 0;
+    size_t slots = 0;
+
+    size_t total() const { return arrays + nodes + key_storage + value_storage + other; }
+    double bytes_per_entry() const { return entries ? static_cast<double>(total()) / entries : 0; }
+    double load_factor() const { return slots ? static_cast<double>(entries) / slots : 0; }
+};
+
+// heap bytes owned by a key or value beyond sizeof(T)
+template<typename T>
+size_t heap_bytes(const T&) {
+    return 0;
+}
+
+inline size_t heap_bytes(const std::string& s) {
+    const char* object = reinterpret_cast<const char*>(&s);
+    bool inline_buffer = s.data() >= object && s.data() < object + sizeof(s);
+    return inline_buffer ? 0 : s.capacity() + 1;
+}
+
+
+#endif //P3_MEMORY_POLICY_H
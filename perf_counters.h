@@ -0,0 +1,117 @@
+#ifndef P3_PERF_COUNTERS_H
+#define P3_PERF_COUNTERS_H
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware counters for the calling thread via perf_event_open, user space only. Each event is
+// opened on its own so one the CPU or kernel does not offer (common in VMs and containers) only
+// leaves its own column empty; when the PMU multiplexes events, counts are scaled up by the
+// fraction of the region's time each one was actually running.
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+    static constexpr const char* NAMES[NUM_EVENTS] = {
+        "Cycles", "Instructions", "L1d_misses", "LLC_misses", "dTLB_misses", "Branch_misses"
+    };
+
+private:
+    int fds[NUM_EVENTS];
+    double counts[NUM_EVENTS] = {};
+
+    // value, time enabled and time running; all three accumulate over the counter's lifetime
+    // (PERF_EVENT_IOC_RESET clears only the value), so a region is measured as their deltas
+    struct Reading {
+        uint64_t value = 0;
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+    Reading begin[NUM_EVENTS];
+
+    static bool read_event(int fd, Reading& reading) {
+        return fd >= 0 && read(fd, &reading, sizeof(reading)) == sizeof(reading);
+    }
+
+    static uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+        return cache | (op << 8) | (result << 16);
+    }
+
+    static int open_event(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+public:
+    PerfCounters() {
+        fds[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[L1D_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D,
+                PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+        fds[LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[DTLB_MISSES] = open_event(PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB,
+                PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+        fds[BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    bool has(Event event) const {
+        return fds[event] >= 0;
+    }
+
+    bool any() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            if (!read_event(fds[e], begin[e])) continue;
+            ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    void stop() {
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        for (int e = 0; e < NUM_EVENTS; e++) {
+            counts[e] = 0;
+            Reading end;
+            if (!read_event(fds[e], end) || end.running == begin[e].running)
+                continue;
+            counts[e] = static_cast<double>(end.value - begin[e].value) * (end.enabled - begin[e].enabled) /
+                        (end.running - begin[e].running);
+        }
+    }
+
+    // count from the last start()/stop() region
+    double count(Event event) const {
+        return counts[event];
+    }
+};
+
+#endif //P3_PERF_COUNTERS_H
@@ -0,0 +1,53 @@
+#ifndef P3_PROBE_POLICIES_H
+#define P3_PROBE_POLICIES_H
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Probe sequences for OpenAddrHashTable. The table computes the home slot once per operation,
+// asks the policy for a per-key step once, and then advances with next(index, i, step) where i is
+// the number of the probe being made (1, 2, ...), at most capacity. All sequences assume a prime
+// capacity, and wrap around with subtraction rather than a division per probe.
+
+struct LinearProbe {
+    template<typename K>
+    size_t step(const K&, size_t) const { return 1; }
+
+    size_t next(size_t index, size_t, size_t, size_t capacity) const {
+        return index + 1 == capacity ? 0 : index + 1;
+    }
+};
+
+// home + i^2: with a prime capacity the first (capacity + 1) / 2 probes are distinct, which is
+// enough to find a free slot while the table is at most half full
+struct QuadraticProbe {
+    template<typename K>
+    size_t step(const K&, size_t) const { return 1; }
+
+    size_t next(size_t index, size_t i, size_t, size_t capacity) const {
+        size_t next = index + 2 * i - 1;
+        while (next >= capacity) next -= capacity;
+        return next;
+    }
+};
+
+// home + i * (1 + h2(key) % (capacity - 1)): every step size is coprime with a prime capacity,
+// so the sequence visits every slot and keys sharing a home slot diverge immediately
+template<typename K>
+struct DoubleHashProbe {
+    std::function<size_t(const K&, size_t)> second_hasher = [](const K& key, size_t) {
+        return std::hash<K>{}(key);
+    };
+
+    size_t step(const K& key, size_t capacity) const {
+        return capacity > 1 ? 1 + second_hasher(key, capacity) % (capacity - 1) : 1;
+    }
+
+    size_t next(size_t index, size_t, size_t step, size_t capacity) const {
+        return index + step >= capacity ? index + step - capacity : index + step;
+    }
+};
+
+
+#endif //P3_PROBE_POLICIES_H